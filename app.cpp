@@ -4,6 +4,7 @@
 #include <default_params.hpp>
 #include <fstream>
 #include <iostream>
+#include <portfolio.hpp>
 #include <pp.hpp>
 #include <problem.hpp>
 #include <random>
@@ -31,16 +32,18 @@ int main(int argc, char* argv[])
       {"help", no_argument, 0, 'h'},
       {"time-limit", required_argument, 0, 'T'},
       {"make-scen", no_argument, 0, 'P'},
+      {"node-order", required_argument, 0, 'O'},
       {0, 0, 0, 0},
   };
   bool make_scen = false;
   int max_comp_time = -1;
+  std::string node_order = "id";
 
   // command line args
   int opt, longindex;
   opterr = 0;  // ignore getopt error
-  while ((opt = getopt_long(argc, argv, "i:o:s:vhPT:", longopts, &longindex)) !=
-         -1) {
+  while ((opt = getopt_long(argc, argv, "i:o:s:vhPT:O:", longopts,
+                            &longindex)) != -1) {
     switch (opt) {
       case 'i':
         instance_file = std::string(optarg);
@@ -63,6 +66,9 @@ int main(int argc, char* argv[])
       case 'T':
         max_comp_time = std::atoi(optarg);
         break;
+      case 'O':
+        node_order = std::string(optarg);
+        break;
       default:
         break;
     }
@@ -81,6 +87,9 @@ int main(int argc, char* argv[])
   // set max computation time (otherwise, use param in instance_file)
   if (max_comp_time != -1) P.setMaxCompTime(max_comp_time);
 
+  // renumber nodes inside solvers, plans are the same
+  P.setNodeOrder(CSRGraph::getOrder(node_order));
+
   // create scenario
   if (make_scen) {
     P.makeScenFile(output_file);
@@ -108,6 +117,8 @@ std::unique_ptr<Solver> getSolver(const std::string solver_name, Problem* P,
     solver = std::make_unique<PP>(P);
   } else if (solver_name == "DBS") {
     solver = std::make_unique<DBS>(P);
+  } else if (solver_name == "PORTFOLIO") {
+    solver = std::make_unique<Portfolio>(P);
   } else {
     std::cout << "warn@app: "
               << "unknown solver name, " + solver_name + ", continue by PP"
@@ -131,9 +142,12 @@ void printHelp()
             << "  -s --solver [SOLVER_NAME]     solver, choose from the below\n"
             << "  -T --time-limit [INT]         max computation time (ms)\n"
             << "  -P --make-scen                make scenario file using "
-               "random starts/goals"
+               "random starts/goals\n"
+            << "  -O --node-order [NAME]        order of nodes in solvers, "
+               "id/hilbert/rcm"
             << "\n\nSolver Options:" << std::endl;
   // each solver
   PP::printHelp();
   DBS::printHelp();
+  Portfolio::printHelp();
 }
@@ -4,6 +4,7 @@
 #include <default_params.hpp>
 #include <fstream>
 #include <iostream>
+#include <portfolio.hpp>
 #include <pp.hpp>
 #include <problem.hpp>
 #include <random>
@@ -32,9 +33,11 @@ int main(int argc, char* argv[])
       {"prob", required_argument, 0, 'p'},
       {"agent", required_argument, 0, 'k'},
       {"seed", required_argument, 0, 'r'},
+      {"node-order", required_argument, 0, 'O'},
       {0, 0, 0, 0},
   };
   int max_comp_time = -1;
+  std::string node_order = "id";
 
   int n = 0;     // #vertex
   float p = 0;   // prob
@@ -44,7 +47,7 @@ int main(int argc, char* argv[])
   // command line args
   int opt, longindex;
   opterr = 0;  // ignore getopt error
-  while ((opt = getopt_long(argc, argv, "o:s:vhT:n:p:k:r:", longopts,
+  while ((opt = getopt_long(argc, argv, "o:s:vhT:n:p:k:r:O:", longopts,
                             &longindex)) != -1) {
     switch (opt) {
       case 'o':
@@ -74,6 +77,9 @@ int main(int argc, char* argv[])
       case 'r':
         seed = std::atoi(optarg);
         break;
+      case 'O':
+        node_order = std::string(optarg);
+        break;
       default:
         break;
     }
@@ -92,6 +98,9 @@ int main(int argc, char* argv[])
   // set max computation time (otherwise, use param in instance_file)
   if (max_comp_time != -1) P.setMaxCompTime(max_comp_time);
 
+  // renumber nodes inside solvers, plans are the same
+  P.setNodeOrder(CSRGraph::getOrder(node_order));
+
   // solve
   auto solver = getSolver(solver_name, &P, verbose, argc, argv_copy);
   solver->solve();
@@ -113,6 +122,8 @@ std::unique_ptr<Solver> getSolver(const std::string solver_name, Problem* P,
     solver = std::make_unique<PP>(P);
   } else if (solver_name == "DBS") {
     solver = std::make_unique<DBS>(P);
+  } else if (solver_name == "PORTFOLIO") {
+    solver = std::make_unique<Portfolio>(P);
   } else {
     std::cout << "warn@app: "
               << "unknown solver name, " + solver_name + ", continue by PP"
@@ -138,8 +149,11 @@ void printHelp()
             << "  -h --help                     help\n"
             << "  -s --solver [SOLVER_NAME]     solver, choose from the below\n"
             << "  -T --time-limit [INT]         max computation time (ms)\n"
+            << "  -O --node-order [NAME]        order of nodes in solvers, "
+               "id/hilbert/rcm"
             << "\n\nSolver Options:" << std::endl;
   // each solver
   PP::printHelp();
   DBS::printHelp();
+  Portfolio::printHelp();
 }
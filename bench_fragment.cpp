@@ -0,0 +1,135 @@
+/*
+ * micro benchmark of TableFragment::registerNewPath,
+ * duplication check by linear scan (old) vs. by hash index (new)
+ */
+
+#include <getopt.h>
+
+#include <fragment.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <util.hpp>
+
+void printHelp();
+
+// register all paths, return elapsed time (ms)
+double run(Grid* G, const std::vector<Path>& paths, const int max_fragment_size,
+           const bool use_index, const int threads_num, const bool scc_pruning,
+           int& fragments_num)
+{
+  auto t_s = Time::now();
+  TableFragment table(G, max_fragment_size);
+  table.setDuplicationIndex(use_index);
+  table.setThreadsNum(threads_num);
+  table.setSccPruning(scc_pruning);
+  for (int i = 0; i < (int)paths.size(); ++i) {
+    table.registerNewPath(i, paths[i], true);
+  }
+  fragments_num = table.getFragmentsNum();
+  return std::chrono::duration<double, std::milli>(Time::now() - t_s).count();
+}
+
+int main(int argc, char* argv[])
+{
+  std::string map_file = "den520d.map";
+  int num_agents = 30;
+  int max_fragment_size = -1;
+  int seed = 0;
+  int repetition = 1;
+  int threads_num = 1;
+  bool scc_pruning = false;
+
+  struct option longopts[] = {
+      {"map", required_argument, 0, 'i'},
+      {"agents", required_argument, 0, 'n'},
+      {"max-fragment-size", required_argument, 0, 'f'},
+      {"seed", required_argument, 0, 's'},
+      {"repetition", required_argument, 0, 'r'},
+      {"threads", required_argument, 0, 't'},
+      {"scc-pruning", no_argument, 0, 'p'},
+      {"help", no_argument, 0, 'h'},
+      {0, 0, 0, 0},
+  };
+  int opt, longindex;
+  while ((opt = getopt_long(argc, argv, "i:n:f:s:r:t:ph", longopts,
+                            &longindex)) != -1) {
+    switch (opt) {
+      case 'i':
+        map_file = std::string(optarg);
+        break;
+      case 'n':
+        num_agents = std::atoi(optarg);
+        break;
+      case 'f':
+        max_fragment_size = std::atoi(optarg);
+        break;
+      case 's':
+        seed = std::atoi(optarg);
+        break;
+      case 'r':
+        repetition = std::atoi(optarg);
+        break;
+      case 't':
+        threads_num = std::atoi(optarg);
+        break;
+      case 'p':
+        scc_pruning = true;
+        break;
+      case 'h':
+        printHelp();
+        return 0;
+      default:
+        break;
+    }
+  }
+
+  // create shortest paths between random nodes
+  Grid G(map_file);
+  std::mt19937 MT(seed);
+  std::vector<Path> paths;
+  while ((int)paths.size() < num_agents) {
+    auto s = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    auto g = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    if (s == nullptr || g == nullptr || s == g) continue;
+    auto p = G.getPath(s, g, false);
+    if (!p.empty()) paths.push_back(p);
+  }
+  int edges = 0;
+  for (auto& p : paths) edges += p.size() - 1;
+
+  std::cout << "map=" << map_file << ", agents=" << num_agents
+            << ", edges=" << edges
+            << ", max_fragment_size=" << max_fragment_size
+            << ", threads=" << threads_num << ", scc_pruning=" << scc_pruning
+            << std::endl;
+  for (auto use_index : {false, true}) {
+    double best = -1;
+    int fragments_num = 0;
+    for (int k = 0; k < repetition; ++k) {
+      auto t = run(&G, paths, max_fragment_size, use_index, threads_num,
+                   scc_pruning, fragments_num);
+      if (best < 0 || t < best) best = t;
+    }
+    std::cout << std::setw(12) << (use_index ? "hash-index" : "linear-scan")
+              << ": " << std::setw(10) << std::fixed << std::setprecision(1)
+              << best << " ms, fragments=" << fragments_num
+              << ", paths/s=" << std::setprecision(0)
+              << num_agents / best * 1000 << std::endl;
+  }
+
+  return 0;
+}
+
+void printHelp()
+{
+  std::cout << "\nUsage: ./bench_fragment [OPTIONS]\n"
+            << "  -i --map [MAP_FILE]           map file (default: den520d)\n"
+            << "  -n --agents [INT]             number of paths\n"
+            << "  -f --max-fragment-size [INT]  maximum fragment size\n"
+            << "  -s --seed [INT]               seed\n"
+            << "  -r --repetition [INT]         repetition, report the best\n"
+            << "  -t --threads [INT]            threads to connect fragments\n"
+            << "  -p --scc-pruning              fragments only inside SCCs\n"
+            << "  -h --help                     help" << std::endl;
+}
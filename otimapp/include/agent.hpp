@@ -2,6 +2,8 @@
 #include <graph.hpp>
 #include <memory>
 
+#include "csr_graph.hpp"
+
 struct MAPF_DP_Agent;
 using MAPF_DP_Agent_p = std::shared_ptr<MAPF_DP_Agent>;
 using MAPF_DP_Agents = std::vector<MAPF_DP_Agent_p>;
@@ -26,19 +28,24 @@ struct Agent {
   Node* tail;  // tail
   Path path;   // plan
 
-  Agent(int _id, const Path& _path);
+  // indices of the path in occupancy, node ids without csr
+  std::vector<int> path_index;
+
+  Agent(int _id, const Path& _path, const CSRGraph* csr = nullptr);
   virtual ~Agent() {}
 
   virtual void activate(std::vector<int>& occupancy) {}
 
   Node* getNextNode() const;
+  int getNextIndex() const;  // the next node must exist
+  int getTailIndex() const;
   bool isFinished() const;
   State getState() const;
 };
 
 // agent for MAPF-DP
 struct MAPF_DP_Agent : public Agent {
-  MAPF_DP_Agent(int _id, const Path& _path);
+  MAPF_DP_Agent(int _id, const Path& _path, const CSRGraph* csr = nullptr);
   ~MAPF_DP_Agent() {}
 
   void activate(std::vector<int>& occupancy);
@@ -46,7 +53,7 @@ struct MAPF_DP_Agent : public Agent {
 
 // pure agent
 struct PrimitiveAgent : public Agent {
-  PrimitiveAgent(int _id, const Path& _path);
+  PrimitiveAgent(int _id, const Path& _path, const CSRGraph* csr = nullptr);
   ~PrimitiveAgent() {}
 
   void activate(std::vector<int>& occupancy);
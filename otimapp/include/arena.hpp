@@ -0,0 +1,115 @@
+/*
+ * bump allocator, all objects are released at once
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+class Arena
+{
+private:
+  static constexpr std::size_t DEFAULT_BLOCK_SIZE = 1 << 16;  // bytes
+
+  struct Block {
+    std::unique_ptr<char[]> data;
+    std::size_t size;
+  };
+
+  const std::size_t block_size;  // size of each standard block
+  std::vector<Block> blocks;     // allocated memory
+  std::size_t block_index;       // block currently used
+  std::size_t offset;            // used bytes in the current block
+  std::size_t used_bytes;        // total bytes handed out
+  std::size_t reserved_bytes;    // total size of blocks
+
+  // move to a block with enough space, allocate it when necessary
+  void nextBlock(const std::size_t size)
+  {
+    while (block_index + 1 < blocks.size()) {
+      ++block_index;
+      offset = 0;
+      if (blocks[block_index].size >= size) return;
+    }
+    const std::size_t s = std::max(size, block_size);
+    blocks.push_back({std::unique_ptr<char[]>(new char[s]), s});
+    reserved_bytes += s;
+    block_index = blocks.size() - 1;
+    offset = 0;
+  }
+
+public:
+  Arena(const std::size_t _block_size = DEFAULT_BLOCK_SIZE)
+      : block_size(_block_size),
+        block_index(0),
+        offset(0),
+        used_bytes(0),
+        reserved_bytes(0)
+  {
+  }
+  ~Arena() {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // raw memory, aligned with align (power of two)
+  void* allocate(const std::size_t size, const std::size_t align)
+  {
+    const std::size_t required = size + align - 1;
+    if (blocks.empty() || offset + required > blocks[block_index].size) {
+      nextBlock(required);
+    }
+    auto addr =
+        reinterpret_cast<std::uintptr_t>(blocks[block_index].data.get()) +
+        offset;
+    auto aligned = (addr + align - 1) & ~(std::uintptr_t)(align - 1);
+    offset += (aligned - addr) + size;
+    used_bytes += size;
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  // construct an object on the arena, destructor is never called
+  template <typename T, typename... Args>
+  T* create(Args&&... args)
+  {
+    return new (allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // uninitialized array
+  template <typename T>
+  T* allocateArray(const std::size_t n)
+  {
+    return static_cast<T*>(allocate(sizeof(T) * n, alignof(T)));
+  }
+
+  // position of the arena, used to release memory allocated after that
+  struct Mark {
+    std::size_t block_index;
+    std::size_t offset;
+    std::size_t used_bytes;
+  };
+  Mark getMark() const { return {block_index, offset, used_bytes}; }
+  void rewind(const Mark& mark)
+  {
+    block_index = mark.block_index;
+    offset = mark.offset;
+    used_bytes = mark.used_bytes;
+  }
+
+  // release everything but keep blocks for reuse
+  void reset()
+  {
+    block_index = 0;
+    offset = 0;
+    used_bytes = 0;
+  }
+
+  std::size_t getUsedBytes() const { return used_bytes; }
+  std::size_t getReservedBytes() const { return reserved_bytes; }
+};
@@ -0,0 +1,79 @@
+/*
+ * priority queue with small non-negative integer keys, smaller keys first
+ * elements with the same key are ordered by a binary heap with a comparator,
+ * elements the comparator cannot tell apart are popped in order of pushes,
+ * i.e., the same order as one heap ordered by (key, comparator, push order)
+ */
+
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+template <typename T>
+class BucketQueue
+{
+private:
+  struct Entry {
+    T x;
+    uint64_t stamp;  // order of pushes
+  };
+  std::vector<std::vector<Entry>> buckets;  // heap of each key
+  int key_min;          // buckets below this are empty
+  int key_max;          // buckets above this are untouched
+  std::size_t size;     // number of elements
+  uint64_t stamp_next;  // stamp of the next push
+
+  // compare(a, b) -> true, b is popped before a, ties by stamps
+  template <typename Compare>
+  static auto getEntryCompare(Compare& compare)
+  {
+    return [&compare](const Entry& a, const Entry& b) {
+      if (compare(a.x, b.x)) return true;
+      if (compare(b.x, a.x)) return false;
+      return a.stamp > b.stamp;
+    };
+  }
+
+public:
+  BucketQueue() : key_min(0), key_max(-1), size(0), stamp_next(0) {}
+  ~BucketQueue() {}
+
+  bool empty() const { return size == 0; }
+
+  // remove all elements, memory of buckets is kept
+  void clear()
+  {
+    for (int k = key_min; k <= key_max; ++k) buckets[k].clear();
+    key_min = 0;
+    key_max = -1;
+    size = 0;
+    stamp_next = 0;
+  }
+
+  // compare(a, b) -> true, b is popped before a
+  template <typename Compare>
+  void push(const T& x, const int key, Compare& compare)
+  {
+    if (key >= (int)buckets.size()) buckets.resize(key + 1);
+    auto& bucket = buckets[key];
+    bucket.push_back({x, stamp_next++});
+    std::push_heap(bucket.begin(), bucket.end(), getEntryCompare(compare));
+    if (size == 0 || key < key_min) key_min = key;
+    key_max = std::max(key_max, key);
+    ++size;
+  }
+
+  // the first element, the queue must not be empty
+  template <typename Compare>
+  T pop(Compare& compare)
+  {
+    while (buckets[key_min].empty()) ++key_min;
+    auto& bucket = buckets[key_min];
+    std::pop_heap(bucket.begin(), bucket.end(), getEntryCompare(compare));
+    T x = bucket.back().x;
+    bucket.pop_back();
+    --size;
+    return x;
+  }
+};
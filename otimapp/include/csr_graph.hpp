@@ -0,0 +1,67 @@
+/*
+ * compressed sparse row representation of the graph, with integer indices
+ *
+ * Indices are node ids by default. Otherwise, nodes are renumbered so that
+ * close nodes have close indices, e.g., by a Hilbert curve for grids, and
+ * obstacles of grids are removed. Neighbors of each node are stored in the
+ * same order as Node::neighbor, so searches on this representation give
+ * identical results in any order.
+ */
+
+#pragma once
+#include <graph.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CSRGraph
+{
+public:
+  // order of indices
+  enum Order {
+    ID,       // node ids
+    HILBERT,  // Hilbert curve of coordinates, for grids
+    RCM       // reverse Cuthill-McKee, for general graphs
+  };
+
+private:
+  const Order order;
+  std::vector<Node*> nodes;        // index -> node, nullptr for obstacles
+  std::vector<int32_t> index_of;   // node id -> index, -1 for obstacles
+  std::vector<int32_t> offsets;    // neighbors of v: [offsets[v], offsets[v+1])
+  std::vector<int32_t> neighbors;  // indices
+  std::vector<uint64_t> goals;     // bitmap of goal locations
+
+  static Nodes getHilbertOrder(Graph* G);
+  static Nodes getRCMOrder(Graph* G);
+
+public:
+  // iterable range of neighbors
+  struct Neighbors {
+    const int32_t* first;
+    const int32_t* last;
+    const int32_t* begin() const { return first; }
+    const int32_t* end() const { return last; }
+    int size() const { return last - first; }
+  };
+
+  CSRGraph(Graph* G, const Order _order = ID);
+  ~CSRGraph();
+
+  Order getOrder() const { return order; }
+  int getNodesSize() const { return nodes.size(); }
+  Node* getNode(const int v) const { return nodes[v]; }
+  int getIndex(const int id) const { return index_of[id]; }
+  int getIndex(Node* const v) const { return index_of[v->id]; }
+  Neighbors getNeighbors(const int v) const
+  {
+    return {neighbors.data() + offsets[v], neighbors.data() + offsets[v + 1]};
+  }
+
+  void setGoals(const Nodes& config_g);
+  bool isGoal(const int v) const { return (goals[v >> 6] >> (v & 63)) & 1; }
+  bool isGoal(Node* const v) const { return isGoal(getIndex(v)); }
+
+  static Order getOrder(const std::string& name);  // ID when unknown
+};
@@ -0,0 +1,115 @@
+/*
+ * incremental detection of potential deadlocks without fragments
+ *
+ * A potential deadlock is a cycle in the graph of moves labelled by agents,
+ * where all agents are distinct. Strongly connected components of the graph
+ * are maintained with a topological order (Pearce and Kelly), and a cycle
+ * is searched only inside a component.
+ */
+
+#pragma once
+#include <graph.hpp>
+#include <vector>
+
+class CycleDetector
+{
+private:
+  struct Edge {
+    int from;
+    int to;
+    int agent;
+    bool removed;
+  };
+
+  Graph* const G;
+  const int max_length;  // maximum number of agents in a cycle, -1 -> inf
+
+  std::vector<Edge> edges;
+  std::vector<std::vector<int>> out_edges;    // edge ids from each node
+  std::vector<std::vector<int>> in_edges;     // edge ids to each node
+  std::vector<std::vector<int>> agent_edges;  // edge ids of each agent
+  int edges_num;    // number of live edges
+  int removed_num;  // number of removed edges after the last rebuild
+
+  // components, never split by removing edges and rebuilt occasionally
+  std::vector<int> comp_parent;                // union-find
+  std::vector<std::vector<int>> comp_members;  // nodes of each root
+  std::vector<int> ord;                        // topological order of roots
+
+  // buffers of search
+  std::vector<int> stamp;  // visited components
+  int stamp_cnt;
+  int version;  // incremented when edges change
+
+  // backward search, depending only on the goal and the agent
+  int bfs_from;
+  int bfs_agent;
+  int bfs_version;
+  int bfs_stamp;
+  std::vector<int> edge_stamp;  // moves which can reach the goal
+  std::vector<int> edge_dist;   // number of moves to the goal
+  int search_lo;  // lower bound of the order in the current search
+  std::vector<int> node_stamp;  // expanded nodes
+  std::vector<int> node_agent;  // agent of the first expansion, -1 -> both
+  std::vector<bool> on_path;
+  std::vector<std::vector<int>> next_moves;  // for each node
+
+  // search from a node fails while these nodes are on the path and the
+  // number of agents is at least length, regardless of agents
+  struct Nogood {
+    int stamp = 0;  // valid when equal to stamp_cnt
+    std::vector<int> nodes;
+    int length = 0;
+  };
+  std::vector<Nogood> nogoods;
+
+  // bipartite matching between moves on the path and agents
+  std::vector<std::vector<int>> candidates;  // agents of each move
+  std::vector<int> step_agent;               // -1 -> unassigned
+  std::vector<int> agent_step;               // -1 -> unassigned
+  std::vector<int> agent_stamp;              // for augmenting paths
+  int agent_stamp_cnt;
+
+  int findComp(int v);
+  // add edge to components and topological order
+  // nodes of components merged into another are appended to absorbed
+  void updateOrder(const int from, const int to,
+                   std::vector<int>* absorbed = nullptr);
+  // compute components from scratch
+  void rebuild();
+  // moves which can reach the goal without using agent, see findCycle
+  void searchBackward(const int goal, const int agent, const int hi);
+  // depth first search of a cycle, see findCycle
+  // record the conditions of failure in nogoods
+  bool searchCycle(const int v, const int goal, std::vector<int>& path);
+  // find an augmenting path from the move
+  bool assignAgent(const int step);
+
+public:
+  CycleDetector(Graph* _G, const int _max_length = -1);
+  ~CycleDetector();
+
+  // register the move from -> to of agent, return true if closing a cycle
+  bool addEdge(const int from, const int to, const int agent,
+               std::vector<int>& path, std::vector<int>& agents);
+
+  // register the move without search
+  // nodes whose components are merged into others are appended to absorbed
+  void insertEdge(const int from, const int to, const int agent,
+                  std::vector<int>* absorbed = nullptr);
+
+  // whether two nodes are in the same component, components are never split
+  // by removing moves until rebuilt, i.e., false positives exist
+  bool isSameComp(const int v, const int u);
+
+  // find a cycle including the move from -> to of agent
+  // path = [from, to, ..., from], agents = [agent, ...]
+  bool findCycle(const int from, const int to, const int agent,
+                 std::vector<int>& path, std::vector<int>& agents);
+
+  // remove all moves of agent
+  void removeAgent(const int agent);
+
+  int getOutEdgesNum(const int v) const { return out_edges[v].size(); }
+  int getEdgesNum() const { return edges_num; }
+};
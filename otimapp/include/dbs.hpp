@@ -16,6 +16,21 @@ private:
   int max_fragment_size;  // maximum fragment size
   static constexpr int DEFAULT_MAX_FRAGMENT_SIZE = -1;
 
+  int detection_threads;  // threads for deadlock detection
+  static constexpr int DEFAULT_DETECTION_THREADS = 1;
+
+  // true -> detect cycles of moves instead of enumerating fragments
+  bool cycle_detection;
+
+  // true -> create fragments only inside strongly connected components
+  bool scc_pruning;
+
+  int fragments_limit;  // fail when exceeding, -1 -> no limit
+  int memory_budget;    // MB, fail when exceeding, 0 -> no limit
+
+  // apply options above to the table
+  void setupTable(TableFragment* table) const;
+
   // main
   void run();
 
@@ -29,26 +44,59 @@ private:
   using Constraint_p = std::shared_ptr<Constraint>;
   using Constraints = std::vector<Constraint_p>;
 
+  struct HighLevelNode;
+  using HighLevelNode_p = std::shared_ptr<HighLevelNode>;
+  using HighLevelNodes = std::vector<HighLevelNode_p>;
+
+  // each node keeps only the difference from its parent
   struct HighLevelNode {
-    Plan paths;               // solution
-    Constraints constraints;  // constraints
+    HighLevelNode_p parent;   // nullptr -> root
+    Constraint_p constraint;  // added constraint, nullptr -> root
+    Path path;                // new path of constraint->agent
+    Plan paths;               // solution, only for the root
+    int constraints_num;      // number of constraints from the root
     int f;                    // #(head-on collisions)
     bool valid;               // false -> no path is found
 
-    HighLevelNode() : constraints({}), f(0), valid(true) {}
+    HighLevelNode()
+        : parent(nullptr),
+          constraint(nullptr),
+          constraints_num(0),
+          f(0),
+          valid(true)
+    {
+    }
+
+    // release the chain of parents iteratively, recursive destruction of a
+    // deep search tree may overflow the stack
+    ~HighLevelNode()
+    {
+      auto p = std::move(parent);
+      while (p != nullptr && p.use_count() == 1) p = std::move(p->parent);
+    }
   };
-  using HighLevelNode_p = std::shared_ptr<HighLevelNode>;
-  using HighLevelNodes = std::vector<HighLevelNode_p>;
+
+  // shared table of fragments, synchronized with the evaluated node
+  // agents are registered in order of ids, the prefix of the same paths is
+  // kept by rolling back to the checkpoint of the first different path,
+  // a new table is created when nothing is kept or with -c and -g
+  std::unique_ptr<TableFragment> table;
+  Plan table_paths;    // registered paths
+  int registered_num;  // agents 0, ..., registered_num - 1 are registered
+  std::vector<TableFragment::Checkpoint> checkpoints;  // before each agent
 
   // setup initial node
   HighLevelNode_p getInitialNode();
 
   // invoke high-level node
-  HighLevelNode_p invoke(HighLevelNode_p n, Constraint_p c);
+  HighLevelNode_p invoke(HighLevelNode_p n, Constraint_p c, const Plan& paths);
+
+  // solution of the node, following parents
+  Plan getPaths(HighLevelNode_p node) const;
 
   // low-level search
-  Path getConstrainedPath(const int id, HighLevelNode_p node);
-  Path getConstrainedPath(const int id, Constraints& _constraints);
+  Path getConstrainedPath(const int id, HighLevelNode_p node,
+                          const Plan& paths);
 
   // get constraints
   Constraints getConstraints(const Plan& paths);
@@ -0,0 +1,94 @@
+/*
+ * cooperative deadline, shared by solvers, A* and the fragment table
+ */
+
+#pragma once
+#include <atomic>
+
+#include "util.hpp"
+
+class Deadline
+{
+private:
+  // read the clock once per this number of checks
+  static constexpr int CHECK_INTERVAL = 128;
+
+  Time::time_point t_end;  // when to stop
+  bool unlimited;          // true -> no time limit
+  std::atomic<bool> over;  // expired or cancelled
+  std::atomic<int> cnt;    // checks after reading the clock
+  Deadline* parent;        // expires together, nullptr -> none
+
+public:
+  Deadline() : unlimited(true), over(false), cnt(0), parent(nullptr) {}
+  Deadline(const int time_limit) : over(false), cnt(0), parent(nullptr)
+  {
+    reset(time_limit);
+  }
+  ~Deadline() {}
+
+  Deadline(const Deadline&) = delete;
+  Deadline& operator=(const Deadline&) = delete;
+
+  // restart with time_limit (ms) from now, negative -> no time limit
+  void reset(const int time_limit)
+  {
+    unlimited = time_limit < 0;
+    if (!unlimited) t_end = Time::now() + std::chrono::milliseconds(time_limit);
+    over = false;
+    cnt = 0;
+  }
+
+  // expire when the parent expires, e.g., workers of a solver
+  void setParent(Deadline* _parent) { parent = _parent; }
+
+  // stop all users, thread-safe
+  void cancel() { over = true; }
+
+  // read the clock, thread-safe
+  bool expiredNow()
+  {
+    if (over.load(std::memory_order_relaxed)) return true;
+    if (!unlimited && Time::now() >= t_end) over = true;
+    if (parent != nullptr && parent->expiredNow()) over = true;
+    return over;
+  }
+
+  // cheap check for inner loops, read the clock only once in a while
+  bool expired()
+  {
+    if (over.load(std::memory_order_relaxed)) return true;
+    if (cnt.fetch_add(1, std::memory_order_relaxed) < CHECK_INTERVAL) {
+      return false;
+    }
+    cnt.store(0, std::memory_order_relaxed);
+    return expiredNow();
+  }
+
+  // same as expired, with a counter held by the caller, e.g., each thread
+  bool expired(int& local_cnt)
+  {
+    if (over.load(std::memory_order_relaxed)) return true;
+    if (++local_cnt < CHECK_INTERVAL) return false;
+    local_cnt = 0;
+    return expiredNow();
+  }
+
+  // remained time (ms), the minimum with the parent, -1 -> no time limit
+  int getRemainedTime() const
+  {
+    if (over) return 0;
+    int t = -1;
+    if (!unlimited) {
+      auto d = std::chrono::duration_cast<std::chrono::milliseconds>(
+                   t_end - Time::now())
+                   .count();
+      t = std::max(0, (int)d);
+    }
+    if (parent == nullptr) return t;
+    const int t_parent = parent->getRemainedTime();
+    if (t == -1) return t_parent;
+    if (t_parent == -1) return t;
+    return std::min(t, t_parent);
+  }
+};
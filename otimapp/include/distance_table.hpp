@@ -0,0 +1,111 @@
+/*
+ * distances from all nodes to goals of agents, by breadth first search
+ *
+ * Agents with the same goal share one row. In compact mode, distances are
+ * 16-bit integers, available when the graph has less than 65535 nodes except
+ * obstacles. In lazy mode, each row is computed when it is accessed for the
+ * first time.
+ *
+ * With a cache directory, rows are also stored in files keyed by the hash of
+ * the graph and the goal, so that other processes can load them.
+ */
+
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "deadline.hpp"
+#include "problem.hpp"
+
+class DistanceTable
+{
+private:
+  Problem* const P;
+  const CSRGraph* const csr;
+  const int nodes_num;  // also the distance of unreachable nodes
+  static constexpr uint16_t UNREACHABLE_COMPACT =
+      std::numeric_limits<uint16_t>::max();
+  const bool compact;   // true -> 16-bit distances
+  const bool lazy;      // true -> compute rows when accessed
+  const std::string cache_dir;  // empty -> no cache
+  uint64_t graph_hash;          // key of cache files
+
+  std::vector<int> agent_row;  // row of each agent
+  std::vector<int> goals;      // goal of each row, index of csr
+  std::vector<int> row_slot;   // position in the storage, -1 -> not computed
+  int slots_num;
+
+  // storage of rows, [slot * nodes_num + index of csr]
+  std::vector<int> data;
+  std::vector<uint16_t> data_compact;
+
+  // buffers of breadth first search, one for each thread
+  struct BfsBuffer {
+    std::vector<int> OPEN;  // FIFO queue, or nodes in the frontier
+    std::vector<int> next_nodes;
+    // for bit-parallel search, one bit for each row
+    std::vector<uint64_t> visited;
+    std::vector<uint64_t> frontier;
+    std::vector<uint64_t> next;
+  };
+  BfsBuffer buf_lazy;
+
+  // whether 16-bit integers can store all distances
+  static bool isCompactAvailable(const CSRGraph* csr);
+  // assign storage to the row
+  void allocateRow(const int row);
+  // breadth first search from the goal of the row
+  template <typename T>
+  void searchDistance(const int row, T* storage, BfsBuffer& buf);
+  // breadth first search from goals of rows[0], ..., rows[num-1] at once,
+  // num <= 64, the results are identical to searchDistance
+  template <typename T>
+  void searchDistanceBitParallel(const int* rows, const int num, T* storage,
+                                 BfsBuffer& buf);
+  // reorder rows into groups of group_size, with goals close to each other
+  std::vector<int> groupRowsByGoals(const std::vector<int>& rows,
+                                    const int group_size);
+  // compute the row in lazy mode
+  int computeRow(const int row);
+
+  // hash of the adjacency, identical for the same map
+  static uint64_t getGraphHash(const CSRGraph* csr);
+  std::string getCacheFileName(const int row) const;
+  // copy the row from the cache, false -> not found or broken
+  bool loadRow(const int row);
+  // write the row to the cache through a temporary file
+  void storeRow(const int row) const;
+
+public:
+  // compact is ignored when the graph is too large
+  DistanceTable(Problem* _P, const bool _compact = false,
+                const bool _lazy = false, const std::string& _cache_dir = "");
+  ~DistanceTable();
+
+  // compute all rows except in lazy mode, stop when the deadline expires
+  void create(const int threads_num = 1, const bool bit_parallel = false,
+              Deadline* deadline = nullptr);
+
+  // distance from the node to the goal of agent i, v is an index of csr
+  int get(const int i, const int v)
+  {
+    int slot = row_slot[agent_row[i]];
+    if (slot == -1) slot = computeRow(agent_row[i]);
+    const std::size_t k = (std::size_t)slot * nodes_num + v;
+    if (!compact) return data[k];
+    const int d = data_compact[k];
+    return d == UNREACHABLE_COMPACT ? nodes_num : d;
+  }
+
+  bool isCompact() const { return compact; }
+  bool isLazy() const { return lazy; }
+  int getRowsNum() const { return goals.size(); }
+  int getComputedRowsNum() const { return slots_num; }
+  std::size_t getBytes() const
+  {
+    return data.capacity() * sizeof(int) +
+           data_compact.capacity() * sizeof(uint16_t);
+  }
+};
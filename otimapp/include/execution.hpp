@@ -56,6 +56,7 @@ public:
   // -------------------------------
   // getter
   Plan getExecResult() const { return exec_result; }
+  bool getExecSucceed() const { return exec_succeed; }
 
   // -------------------------------
   // others
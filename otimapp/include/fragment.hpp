@@ -1,47 +1,380 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <graph.hpp>
+#include <list>
+#include <memory>
 #include <queue>
+#include <unordered_map>
+
+#include "arena.hpp"
+#include "csr_graph.hpp"
+#include "cycle_detector.hpp"
+#include "deadline.hpp"
+#include "thread_pool.hpp"
+#include "util.hpp"
+
+// contiguous array stored on the arena of TableFragment
+template <typename T>
+struct FlatArray {
+  const T* data;
+  int len;
+
+  FlatArray() : data(nullptr), len(0) {}
+  FlatArray(const T* _data, const int _len) : data(_data), len(_len) {}
+
+  int size() const { return len; }
+  bool empty() const { return len == 0; }
+  const T& operator[](const int i) const { return data[i]; }
+  const T& front() const { return data[0]; }
+  const T& back() const { return data[len - 1]; }
+  const T* begin() const { return data; }
+  const T* end() const { return data + len; }
+};
+
+template <typename T>
+static bool inArray(const T a, const FlatArray<T>& arr)
+{
+  return std::find(arr.begin(), arr.end(), a) != arr.end();
+}
+
+// signature of a set of ids, used as a Bloom filter with one hash
+[[maybe_unused]] static uint64_t getSignatureBit(const int id)
+{
+  return (uint64_t)1 << (id & 63);
+}
+
+template <typename Container>
+static uint64_t getSignature(const Container& arr)
+{
+  uint64_t mask = 0;
+  for (auto i : arr) mask |= getSignatureBit(i);
+  return mask;
+}
 
 struct Fragment {
-  std::deque<Node*>
-      path;  // head -> tail, for the convenience, I did not use "clocks"
-  std::deque<int> agents;  // a_i, a_j, ..., a_l
+  FlatArray<int> path;    // node ids, head -> tail, I did not use "clocks"
+  FlatArray<int> agents;  // a_i, a_j, ..., a_l
+  uint64_t key;           // hash of path and set of agents
+  uint64_t mask_path;     // signature of path, see getSignature
+  uint64_t mask_agents;   // signature of agents
+  bool removed;           // used when removing fragments at once
+
+  Fragment() : key(0), mask_path(0), mask_agents(0), removed(false) {}
 
-  Fragment() {}
+  // check whether agent i is included, false positive free
+  bool hasAgent(const int i) const
+  {
+    return (mask_agents & getSignatureBit(i)) && inArray(i, agents);
+  }
+};
+
+// open addressing hash set (linear probing) of fragments
+class FragmentHashSet
+{
+private:
+  std::vector<Fragment*> slots;  // nullptr -> empty
+  std::size_t size;              // number of elements
+
+  void rehash(const std::size_t capacity);
+
+public:
+  FragmentHashSet();
+
+  // equal(c) -> true when c is identical to the query
+  template <typename Equal>
+  Fragment* find(const uint64_t key, Equal equal) const
+  {
+    const std::size_t mask = slots.size() - 1;
+    for (std::size_t i = key & mask; slots[i] != nullptr; i = (i + 1) & mask) {
+      if (slots[i]->key == key && equal(slots[i])) return slots[i];
+    }
+    return nullptr;
+  }
+
+  void insert(Fragment* c);
+  void erase(Fragment* c);  // c must be included
+  std::size_t getSize() const { return size; }
+  std::size_t getCapacity() const { return slots.size(); }
+};
+
+// statistics of TableFragment, accumulated over tables by merge
+struct FragmentStats {
+  std::size_t created = 0;     // fragments created
+  std::size_t duplicates = 0;  // rejected by duplication check
+  std::size_t topology = 0;    // rejected by topology check
+  std::size_t peak_fragments = 0;
+  std::size_t peak_bytes = 0;       // see TableFragment::getMemoryBytes
+  std::size_t max_bucket_from = 0;  // largest list in t_from
+  std::size_t max_bucket_to = 0;    // largest list in t_to
+  std::vector<std::size_t> length_hist;  // created fragments by agents num
+  bool over_limit = false;  // reach the limit of fragments or memory
+
+  void merge(const FragmentStats& other);
 };
 
 struct TableFragment {
-  std::vector<std::vector<Fragment*>> t_from;  // table from
-  std::vector<std::vector<Fragment*>> t_to;    // table to
+  std::vector<std::vector<Fragment*>> t_from;   // table from
+  std::vector<std::vector<Fragment*>> t_to;     // table to
+  std::vector<std::vector<Fragment*>> t_agent;  // fragments of each agent
+  std::vector<Fragment*> t_cycle;  // registered potential deadlocks
   Graph* G;
+  const CSRGraph* csr;    // graph with integer ids
   int max_fragment_size;  // maximum fragment size
 
-  TableFragment(Graph* _G, const int _max_fragment_size = -1);
+private:
+  std::unique_ptr<CSRGraph> csr_owned;  // created when not given
+  Arena arena;        // storage of all fragments, their paths and agents
+  int fragments_num;  // number of registered fragments
+
+  // statistics and limits, see setFragmentsLimit and setMemoryBudget
+  FragmentStats stats;
+  std::size_t agent_entries_num;  // number of elements in t_agent
+  int fragments_limit;            // -1 -> no limit
+  std::size_t memory_budget;      // bytes, 0 -> no limit
+  // update statistics for adding (sign = 1) or removing (-1) the fragment
+  void countFragment(const Fragment* c, const int sign);
+  // time limit, or the limit of fragments
+  bool isInterrupted(Deadline* deadline)
+  {
+    return stats.over_limit || (deadline != nullptr && deadline->expired());
+  }
+
+  // buffers to create a new fragment, reused to avoid heap allocation
+  std::vector<int> buf_path;
+  std::vector<int> buf_agents;
+
+  // index for duplication check, keyed by Fragment::key
+  FragmentHashSet index;
+  bool use_index;       // false -> linear scan of t_from, for benchmarking
+  bool use_signatures;  // false -> all bits set, i.e., always exact checks
+
+  // journal of changes after the first checkpoint, used for rollback
+  struct Change {
+    bool added;              // true -> added, false -> removed
+    Fragment* c;             // fragment
+    std::size_t pos_offset;  // positions in tables when removed
+  };
+  std::vector<Change> journal;
+  std::vector<int> journal_positions;  // t_from, t_to, (t_cycle), t_agent
+  bool journaling;
+
+  // remove one fragment from all tables
+  void removeFragment(Fragment* c);
+  // remove all fragments including agent id
+  void removeFragments(const int id);
+
+  // for topology check, valid only when max_fragment_size > 0
+  // nodes within max_fragment_size from each node, (id, distance) sorted by id
+  std::vector<std::vector<std::pair<int, int>>> t_ball;
+  std::vector<bool> t_ball_computed;
+  // LRU cache of exact checks, keyed by (sorted prohibited nodes, head, tail)
+  static constexpr std::size_t MEMO_CAPACITY = 1 << 16;
+  struct MemoEntry {
+    std::vector<int> key;  // compared on hits, hashes may collide
+    uint64_t hash;
+    bool valid;
+  };
+  std::list<MemoEntry> memo_list;  // recently used -> front
+  std::unordered_multimap<uint64_t, std::list<MemoEntry>::iterator> memo_table;
+  std::vector<int> memo_key;  // buffer
+  // buffers of breadth first search, one for each thread
+  struct SearchBuffer {
+    std::vector<int> stamp;
+    std::vector<int> dist;
+    std::queue<int> OPEN;
+    int cnt = 0;
+  };
+  SearchBuffer bfs;
+  bool use_topology_memo;  // false -> exact checks always, for testing
+
+  // compute the ball of head, not thread-safe
+  void computeBall(const int head);
+  // check by manhattan distance and balls, the ball of head must be computed
+  bool isValidLowerBound(const std::vector<int>& path) const;
+  // exact check by breadth first search avoiding the path
+  bool existClosingPath(const std::vector<int>& path, const int max_dist,
+                        SearchBuffer& buf) const;
+
+  // parallel join of fragments, see registerNewPath
+  static constexpr int PARALLEL_MIN_PAIRS = 1024;  // otherwise sequential
+  std::unique_ptr<ThreadPool> pool;  // nullptr -> single thread
+  // candidates found by each thread, merged in order of threads
+  struct Staging {
+    struct Entry {
+      std::size_t offset;  // position in data, path then agents
+      int path_len;
+      int agents_len;
+      uint64_t key;
+    };
+    std::vector<Entry> entries;
+    std::vector<int> data;
+    std::vector<int> path;    // buffer
+    std::vector<int> agents;  // buffer
+    SearchBuffer bfs;
+    std::size_t duplicates;  // statistics
+    std::size_t topology;
+  };
+  std::vector<Staging> stagings;
+
+  // alternative of fragments, see setCycleDetection
+  std::unique_ptr<CycleDetector> detector;  // nullptr -> use fragments
+  Fragment* registerNewPathWithDetector(const int id, const Path& path,
+                                        const bool force, Deadline* deadline);
+  // register the cycle in buf_path and buf_agents
+  Fragment* registerWitness();
+
+  // pruning by strongly connected components of moves, see setSccPruning
+  // fragments are created only from moves inside a component, others are
+  // pending until their components are merged
+  std::unique_ptr<CycleDetector> moves;  // nullptr -> no pruning
+  struct Move {
+    int from;
+    int to;
+    int agent;
+    enum State { PENDING, READY, DONE } state;  // DONE includes removed
+  };
+  std::vector<Move> t_move;
+  std::vector<std::vector<int>> t_pending_out;  // move ids from each node
+  std::vector<std::vector<int>> t_pending_in;   // move ids to each node
+  std::vector<std::vector<int>> t_agent_move;   // move ids of each agent
+  std::vector<int> ready;  // moves to be registered, in order of arrival
+  std::size_t ready_head;  // first unprocessed element of ready
+  int moves_done_num;      // number of DONE moves in t_move
+  std::vector<int> buf_absorbed;
+  // register moves of the path to the graph and fragments when necessary
+  Fragment* registerNewPathWithPruning(const int id, const Path& path,
+                                       const bool force, Deadline* deadline);
+  // create fragments of ready moves
+  Fragment* registerReadyMoves(const bool force, Deadline* deadline);
+  // remove DONE moves when they occupy most of t_move
+  static constexpr int COMPACT_MIN_MOVES = 1024;
+  void compactMoves();
+
+  // create fragments including the move v_before -> v_next of agent id
+  Fragment* registerNewMove(const int id, Node* v_before, Node* v_next,
+                            const bool force, Deadline* deadline);
+
+  // connect all pairs of fragments by agent id, return deadlock or nullptr
+  Fragment* joinFragments(const int id, const std::vector<Fragment*>& c_tails,
+                          const std::vector<Fragment*>& c_heads,
+                          const bool force, Deadline* deadline);
+  Fragment* joinFragmentsParallel(const int id,
+                                  const std::vector<Fragment*>& c_tails,
+                                  const std::vector<Fragment*>& c_heads,
+                                  const bool force, Deadline* deadline);
+
+public:
+  // state of the table, see getCheckpoint and rollback
+  struct Checkpoint {
+    std::size_t journal_size;
+    Arena::Mark mark;
+  };
+
+  TableFragment(Graph* _G, const int _max_fragment_size = -1,
+                const CSRGraph* _csr = nullptr);
   ~TableFragment();
 
+  // hash of path and set of agents, independent of the order of agents
+  static uint64_t getKey(const std::vector<int>& path,
+                         const std::vector<int>& agents);
+
   // check duplication
-  bool existDuplication(const std::deque<Node*>& path,
-                        const std::deque<int>& agents);
+  bool existDuplication(const std::vector<int>& path,
+                        const std::vector<int>& agents, const uint64_t key);
 
   // branching, valid only when max_fragment_size > 0
-  bool isValidTopologyCondition(const std::deque<Node*>& path) const;
+  bool isValidTopologyCondition(const std::vector<int>& path);
 
   // create new entry
-  Fragment* createNewFragment(const std::deque<Node*>& path,
-                              const std::deque<int>& agents);
+  Fragment* createNewFragment(const std::vector<int>& path,
+                              const std::vector<int>& agents,
+                              const uint64_t key);
 
   // return potential deadlock if exists
   Fragment* getPotentialDeadlockIfExist(const int id, Node* head,
                                         Fragment* c_base, Node* tail);
-  Fragment* getPotentialDeadlockIfExist(const std::deque<Node*>& path,
-                                        const std::deque<int>& agents);
+  Fragment* getPotentialDeadlockIfExist(const std::vector<int>& path,
+                                        const std::vector<int>& agents);
 
   // return deadlock or nullptr
   // force = false -> return when finding first cycle, false -> register all
   // info
-  Fragment* registerNewPath(const int id, const Path path,
+  // deadline = nullptr -> no time limit, return nullptr when expired
+  Fragment* registerNewPath(const int id, const Path& path,
                             const bool force = false,
-                            const int time_limit = -1);
+                            Deadline* deadline = nullptr);
+
+  // remove all fragments including agent id
+  void unregisterPath(const int id);
+
+  // return one of registered potential deadlocks, or nullptr
+  Fragment* getPotentialDeadlock() const
+  {
+    return t_cycle.empty() ? nullptr : t_cycle.front();
+  }
+
+  // whether the move parent -> child of agent id completes potential deadlocks
+  bool existPotentialDeadlock(const int id, Node* parent, Node* child);
+
+  // number of fragments from v, used to break ties of A*
+  // with cycle detection, the number of moves from v since fragments are not
+  // enumerated, so plans may differ from the fragment backend
+  // with SCC pruning, fragments of pending moves are not counted, so tables
+  // used for the tie-break must not prune
+  int countFrom(const int v) const
+  {
+    return detector == nullptr ? t_from[v].size()
+                               : detector->getOutEdgesNum(v);
+  }
+
+  // record the current state, changes after this are journaled
+  // not available with cycle detection
+  Checkpoint getCheckpoint();
+  // undo all changes after the checkpoint, memory is also released
+  void rollback(const Checkpoint& checkpoint);
+  // stop journaling, all checkpoints become invalid
+  void clearCheckpoints();
+
+  // number of threads to connect fragments, 1 -> sequential (default)
+  void setThreadsNum(const int threads_num);
+  int getThreadsNum() const { return pool == nullptr ? 1 : pool->size(); }
+
+  // true -> detect potential deadlocks as cycles of moves without enumerating
+  // fragments, only cycles are registered, call before registration
+  void setCycleDetection(const bool flag);
+  bool isCycleDetection() const { return detector != nullptr; }
+
+  // true -> create fragments only inside strongly connected components of
+  // moves, call before registration, false by default
+  // taking a checkpoint completes all fragments and disables the pruning
+  void setSccPruning(const bool flag);
+  bool isSccPruning() const { return moves != nullptr; }
+
+  // true -> use hash index for duplication check (default)
+  void setDuplicationIndex(const bool flag) { use_index = flag; }
+
+  // true -> filter membership tests by signatures (default)
+  // false -> exact checks always, call before registration
+  void setSignatures(const bool flag) { use_signatures = flag; }
+
+  // true -> skip exact topology checks by balls and LRU cache (default)
+  // false -> breadth first search for every check, the same verdicts
+  void setTopologyMemo(const bool flag) { use_topology_memo = flag; }
+
+  // stop creating fragments when exceeding limits, registration returns
+  // nullptr like time limit, the table becomes incomplete
+  void setFragmentsLimit(const int limit) { fragments_limit = limit; }
+  void setMemoryBudget(const std::size_t bytes) { memory_budget = bytes; }
+  bool isOverLimit() const { return stats.over_limit; }
+
+  // statistics
+  int getFragmentsNum() const { return stats.created; }  // including removed
+  int getLiveFragmentsNum() const { return fragments_num; }
+  std::size_t getArenaBytes() const { return arena.getUsedBytes(); }
+  // memory held by fragments, tables, index and journal, approximately
+  std::size_t getMemoryBytes() const;
+  const FragmentStats& getStats() const { return stats; }
 
   // print registered info
   void println();
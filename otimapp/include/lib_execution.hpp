@@ -46,24 +46,40 @@
   if (!sameConfig(P->getConfigStart(), configs[0])) return false;
   if (!sameConfig(P->getConfigGoal(), configs[makespan])) return false;
 
-  // check conflicts and continuity
-  int num_agents = configs[0].size();
+  // check conflicts and continuity, on indices of the CSR graph
+  const CSRGraph* csr = P->getCSR();
+  const int num_agents = configs[0].size();
+  std::vector<int> occupied_prev(csr->getNodesSize(), -1);  // agents at t-1
+  std::vector<int> occupied(csr->getNodesSize(), -1);       // agents at t
+  for (int i = 0; i < num_agents; ++i) {
+    occupied_prev[csr->getIndex(configs[0][i])] = i;
+  }
   for (int t = 1; t <= makespan; ++t) {
     if ((int)configs[t].size() != num_agents) return false;
     for (int i = 0; i < num_agents; ++i) {
-      Node* v_i_t = configs[t][i];
-      Node* v_i_t_1 = configs[t - 1][i];
-      Nodes cands = v_i_t_1->neighbor;
-      cands.push_back(v_i_t_1);
-      if (!inArray(v_i_t, cands)) return false;
-      // see conflicts
-      for (int j = i + 1; j < num_agents; ++j) {
-        Node* v_j_t = configs[t][j];
-        Node* v_j_t_1 = configs[t - 1][j];
-        if (v_i_t == v_j_t) return false;
-        if (v_i_t == v_j_t_1 && v_i_t_1 == v_j_t) return false;
+      const int v_i_t = csr->getIndex(configs[t][i]);
+      const int v_i_t_1 = csr->getIndex(configs[t - 1][i]);
+      // stay or move to a neighbor
+      if (v_i_t != v_i_t_1) {
+        auto neighbors = csr->getNeighbors(v_i_t_1);
+        if (std::find(neighbors.begin(), neighbors.end(), v_i_t) ==
+            neighbors.end()) {
+          return false;
+        }
+      }
+      // vertex conflicts
+      if (occupied[v_i_t] != -1) return false;
+      occupied[v_i_t] = i;
+    }
+    // swap conflicts, j moves to the location of i at t-1 and vice versa
+    for (int i = 0; i < num_agents; ++i) {
+      const int j = occupied_prev[csr->getIndex(configs[t][i])];
+      if (j != -1 && j != i && configs[t][j] == configs[t - 1][i]) {
+        return false;
       }
     }
+    for (auto v : configs[t - 1]) occupied_prev[csr->getIndex(v)] = -1;
+    std::swap(occupied_prev, occupied);
   }
   return true;
 }
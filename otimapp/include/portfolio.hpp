@@ -0,0 +1,31 @@
+/*
+ * Portfolio: PP and DBS run concurrently, the first solution is returned
+ */
+
+#pragma once
+#include "solver.hpp"
+
+class Portfolio : public Solver
+{
+public:
+  static const std::string SOLVER_NAME;
+
+private:
+  std::vector<std::unique_ptr<Solver>> members;  // PP, DBS
+  std::vector<std::string> members_params;  // options only for each member
+  int winner;                               // member finished first, -1 -> none
+  Deadline race;  // members stop when cancelled by the winner
+
+  // main
+  void run();
+
+protected:
+  void makeLogBasicInfo(std::ofstream& log);
+
+public:
+  Portfolio(Problem* _P);
+  ~Portfolio();
+
+  void setParams(int argc, char* argv[]);
+  static void printHelp();
+};
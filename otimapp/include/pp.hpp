@@ -3,6 +3,8 @@
  */
 
 #pragma once
+#include <atomic>
+
 #include "solver.hpp"
 
 class PP : public Solver
@@ -18,6 +20,52 @@ private:
   int max_fragment_size;  // maximum fragment size
   static constexpr int DEFAULT_MAX_FRAGMENT_SIZE = -1;
 
+  int detection_threads;  // threads for deadlock detection
+  static constexpr int DEFAULT_DETECTION_THREADS = 1;
+
+  // true -> detect cycles of moves instead of enumerating fragments
+  bool cycle_detection;
+
+  // true -> create fragments only inside strongly connected components
+  bool scc_pruning;
+
+  int fragments_limit;  // fail when exceeding, -1 -> no limit
+  int memory_budget;    // MB, fail when exceeding, 0 -> no limit
+
+  // true -> restart by moving the failed agent forward, reusing the table
+  // and paths before its new position, otherwise by shuffling all
+  bool prefix_restart;
+  int registered_paths_cnt;  // paths registered to tables
+  int reused_paths_cnt;      // paths kept by prefix restarts
+
+  // workers running restarts in parallel, the first success stops others
+  int threads;
+  static constexpr int DEFAULT_THREADS = 1;
+  PP* const root;                 // PP running workers, or this
+  std::atomic<int> restarts_cnt;  // restarts of all workers, used by root
+  int winner;                     // worker found the solution, -1 -> none
+  int winner_itr_cnt;             // restart found the solution, -1 -> none
+
+  // worker of root with its own RNG, sharing the distance table
+  PP(PP* _root, const std::mt19937& _rng);
+
+  // true -> start a new restart, within iter_cnt_max of all workers
+  bool countRestart();
+  // restarts until success, failure or the deadline
+  void runRestarts();
+  // restarts by workers on threads
+  void runWorkers();
+
+  // apply options above to the table
+  void setupTable(TableFragment* table) const;
+
+  // plan agents from position k of id_list, return the position of the
+  // failed agent or -1, checkpoints (optional) record states of the table
+  // before registering each agent
+  int planAgents(const std::vector<int>& id_list, const int k,
+                 TableFragment* table,
+                 std::vector<TableFragment::Checkpoint>* checkpoints);
+
   // main
   void run();
 
@@ -30,4 +78,11 @@ public:
 
   void setParams(int argc, char* argv[]);
   static void printHelp();
+
+  // restarts of all workers, and of the winner (-1 -> none)
+  int getIterCnt() const { return itr_cnt; }
+  int getWinnerIterCnt() const { return winner_itr_cnt; }
+  // of all workers, see prefix_restart
+  int getRegisteredPathsCnt() const { return registered_paths_cnt; }
+  int getReusedPathsCnt() const { return reused_paths_cnt; }
 };
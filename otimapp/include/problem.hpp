@@ -1,7 +1,9 @@
 #pragma once
 #include <graph.hpp>
+#include <mutex>
 #include <random>
 
+#include "csr_graph.hpp"
 #include "default_params.hpp"
 #include "util.hpp"
 
@@ -16,7 +18,7 @@ private:
   std::string instance;  // instance name
   Graph* G;              // graph
   int seed;              // seed
-  std::mt19937* MT;      // randomness
+  std::mt19937* MT;      // randomness, only for creating the instance
   Config config_s;       // initial configuration
   Config config_g;       // goal configuration
   int num_agents;        // number of agents
@@ -24,6 +26,10 @@ private:
 
   const bool is_random_graph;
 
+  CSRGraph* csr;               // built when first used
+  CSRGraph::Order node_order;  // indices of csr
+  std::once_flag csr_flag;     // build csr once, even from several threads
+
   // set starts and goals randomly
   void setRandomStartsGoals();
   void setGoalAvoidanceInstance();
@@ -38,8 +44,11 @@ public:
   ~Problem();
 
   Graph* getG() { return G; }
+  const CSRGraph* getCSR();  // with goals of agents, thread-safe
   int getNum() { return num_agents; }
-  std::mt19937* getMT() { return MT; }
+  // independent RNG for each solver, 0 -> the state after creating the
+  // instance, others -> derived from the seed and the stream, thread-safe
+  std::mt19937 getRNG(const int stream = 0) const;
   Node* getStart(int i) const;  // return start of a_i
   Node* getGoal(int i) const;   // return  goal of a_i
   Config getConfigStart() const { return config_s; };
@@ -50,6 +59,7 @@ public:
   bool isRandomGraph() const { return is_random_graph; }
 
   void setMaxCompTime(const int t) { max_comp_time = t; }
+  void setNodeOrder(const CSRGraph::Order order);  // before solving
 
   // used when making new instance file
   void makeScenFile(const std::string& output_file);
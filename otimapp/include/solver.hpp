@@ -1,11 +1,16 @@
 #pragma once
 #include <getopt.h>
 
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <queue>
-#include <unordered_map>
 
+#include "arena.hpp"
+#include "bucket_queue.hpp"
+#include "deadline.hpp"
+#include "distance_table.hpp"
 #include "fragment.hpp"
 #include "problem.hpp"
 #include "util.hpp"
@@ -15,12 +20,14 @@ class MinimumSolver
 protected:
   std::string solver_name;  // solver name
   Problem* const P;         // problem instance
-  Graph* const G;           // graph
-  std::mt19937* const MT;   // for randomness
+  Graph* const G;           // graph, read-only
+  std::mt19937 rng;         // own RNG, not shared with other solvers
+  std::mt19937* const MT;   // for randomness, points to rng
   const int max_comp_time;  // time limit for computation, ms
   Plan solution;            // solution
   bool solved;              // success -> true, failed -> false (default)
   bool unsolvable;          // default: false, true -> instance is unsolvable
+  Deadline deadline;        // shared by all time-consuming procedures
 
 private:
   int comp_time;             // computation time
@@ -37,14 +44,21 @@ protected:
 
 public:
   MinimumSolver(Problem* _P);
+  MinimumSolver(Problem* _P, const std::mt19937& _rng);  // with another RNG
   virtual ~MinimumSolver(){};
 
   // getter
   Plan getSolution() const { return solution; };
   bool succeed() const { return solved; };
+  bool isUnsolvable() const { return unsolvable; }
   std::string getSolverName() const { return solver_name; };
   int getCompTime() const { return comp_time; }
   int getSolverElapsedTime() const;  // get elapsed time from start
+
+  // stop solving, can be called from another thread
+  void cancel() { deadline.cancel(); }
+  // stop also when the parent expires, e.g., members of a portfolio
+  void setParentDeadline(Deadline* parent) { deadline.setParent(parent); }
 };
 
 // -----------------------------------------------
@@ -58,17 +72,25 @@ private:
 
   // distance to goal
 protected:
-  using DistanceTable = std::vector<std::vector<int>>;  // [agent][node_id]
-  DistanceTable distance_table;                         // distance table
+  std::shared_ptr<DistanceTable> distance_table;  // created in exec
+  int distance_threads;  // threads for creating the distance table
+  static constexpr int DEFAULT_DISTANCE_THREADS = 1;
+  bool bit_parallel_bfs;  // true -> search from 64 goals at once
+  bool compact_distance;  // true -> 16-bit distances
+  bool lazy_distance;     // true -> compute rows when accessed
+  std::string distance_cache;  // directory of distance files, empty -> none
 
-  // goal location
+  // graph with integer ids, also has goal locations
 protected:
-  std::vector<bool> table_goals;  // generated in pre-processing, goal location
+  const CSRGraph* const csr;
 
   // for profiling
 protected:
   int elapsed_time_pathfinding;
   int elapsed_time_deadlock_detection;
+  FragmentStats fragment_stats;  // merged from all tables
+  // add profiling info of another solver, e.g., workers
+  void mergeStats(const Solver& other);
 
   // -------------------------------
   // main
@@ -81,7 +103,7 @@ protected:
   // utilities for time
 public:
   int getRemainedTime() const;  // get remained time
-  bool overCompTime() const;    // check time limit
+  bool overCompTime();          // check time limit, reading the clock
 
   // -------------------------------
   // utilities for debug
@@ -112,6 +134,7 @@ protected:
 public:
   virtual void setParams(int argc, char* argv[]){};
   void setVerbose(bool _verbose) { verbose = _verbose; }
+  bool isVerbose() const { return verbose; }
 
   // -------------------------------
   // print
@@ -124,21 +147,22 @@ protected:
   // -------------------------------
   // utilities for distance
 public:
-  int pathDist(const int i,
-               Node* const s) const;  // get path distance between s -> g_i
-  int pathDist(const int i) const;    // get path distance between s_i -> g_i
-  void createDistanceTable();         // compute distance table
-  // use grid-pathfinding
-  int pathDist(Node* const s, Node* const g) const { return G->pathDist(s, g); }
+  // get path distance between s -> g_i, may compute it in lazy mode
+  int pathDist(const int i, Node* const s)
+  {
+    return distance_table->get(i, csr->getIndex(s));
+  }
+  int pathDist(const int i);   // get path distance between s_i -> g_i
+  void createDistanceTable();  // compute distance table, unless already set
+  // use the table of another solver, read-only
+  void setDistanceTable(std::shared_ptr<DistanceTable> table)
+  {
+    distance_table = table;
+  }
 
   // -------------------------------
   // utilities for getting path
 public:
-  // use grid-pathfinding
-  Path getPath(Node* const s, Node* const g, bool cache = false) const
-  {
-    return G->getPath(s, g, cache);
-  }
   // for A-star search
   struct AstarNode {
     Node* v;
@@ -151,7 +175,38 @@ public:
   using CompareAstarNodes = std::function<bool(AstarNode*, AstarNode*)>;
   static CompareAstarNodes compareAstarNodesDefault;
 
-  // implementation of A-star search
+private:
+  // buffers reused over searches, each solver runs on a single thread
+  struct AstarWorkspace {
+    Arena nodes;              // released at the beginning of each search
+    BucketQueue<AstarNode*> open;  // buckets of primary keys
+    std::vector<int> closed;  // closed when equal to generation
+    int generation = 0;
+    std::vector<int> children;  // neighbors in random order
+    int expanded = 0;           // nodes expanded by the last search
+  };
+  AstarWorkspace astar_workspace;
+
+protected:
+  int getExpandedNum() const { return astar_workspace.expanded; }
+
+public:
+  // implementation of A-star search, specialized by policies at compile time
+  // checkInvalidMove(child, parent) -> true, prune the move
+  // getKey(a) -> non-negative integer, smaller keys are expanded first
+  // compare(a, b) -> true, b is expanded before a, among the same key
+  template <typename CheckInvalid, typename Compare, typename GetKey>
+  Path getPathWithPolicy(const int id, CheckInvalid&& checkInvalidMove,
+                         Compare&& compare, GetKey&& getKey);
+  // all nodes have the same key, i.e., a binary heap
+  template <typename CheckInvalid, typename Compare>
+  Path getPathWithPolicy(const int id, CheckInvalid&& checkInvalidMove,
+                         Compare&& compare)
+  {
+    return getPathWithPolicy(id, checkInvalidMove, compare,
+                             [](AstarNode*) { return 0; });
+  }
+  // wrapper with std::function
   Path getPath(const int id, CheckInvalidMove checkInvalidMove,
                CompareAstarNodes compare = compareAstarNodesDefault);
   // prioritized planning
@@ -160,5 +215,87 @@ public:
 
 public:
   Solver(Problem* _P);
+  Solver(Problem* _P, const std::mt19937& _rng);  // with another RNG
   virtual ~Solver();
 };
+
+template <typename CheckInvalid, typename Compare, typename GetKey>
+Path Solver::getPathWithPolicy(const int id, CheckInvalid&& checkInvalidMove,
+                               Compare&& compare, GetKey&& getKey)
+{
+  Node* const s = P->getStart(id);
+  Node* const g = P->getGoal(id);
+
+  // nodes of the previous search are released at once
+  auto& ws = astar_workspace;
+  ws.nodes.reset();
+  auto createNewNode = [&ws](Node* v, int g, int f, AstarNode* p) {
+    return ws.nodes.create<AstarNode>(AstarNode{v, g, f, p});
+  };
+
+  // OPEN and CLOSE list, CLOSE is cleared by a new generation
+  auto& OPEN = ws.open;
+  OPEN.clear();
+  if ((int)ws.closed.size() != csr->getNodesSize() ||
+      ws.generation == std::numeric_limits<int>::max()) {
+    ws.closed.assign(csr->getNodesSize(), 0);
+    ws.generation = 0;
+  }
+  const int generation = ++ws.generation;
+  ws.expanded = 0;
+  auto isClosed = [&](const int v) { return ws.closed[v] == generation; };
+  auto pushOpen = [&](AstarNode* a) { OPEN.push(a, getKey(a), compare); };
+
+  // initial node
+  AstarNode* n = createNewNode(s, 0, pathDist(id, s), nullptr);
+  pushOpen(n);
+
+  // main loop
+  bool invalid = true;
+  while (!OPEN.empty()) {
+    // check time limit, the clock is read once in a while
+    if (deadline.expired()) break;
+
+    // minimum node
+    n = OPEN.pop(compare);
+
+    // check CLOSE list
+    const int v = csr->getIndex(n->v);
+    if (isClosed(v)) continue;
+    ws.closed[v] = generation;
+    ++ws.expanded;
+
+    // check goal condition
+    if (n->v == g) {
+      invalid = false;
+      break;
+    }
+
+    // expand
+    auto& C = ws.children;
+    auto neighbors = csr->getNeighbors(v);
+    C.assign(neighbors.begin(), neighbors.end());
+    std::shuffle(C.begin(), C.end(), *MT);  // randomize
+    for (auto u : C) {
+      // already searched?
+      if (isClosed(u)) continue;
+      // check constraints
+      Node* const child = csr->getNode(u);
+      if (checkInvalidMove(child, n->v)) continue;
+      int g_cost = n->g + 1;
+      int f_cost = g_cost + distance_table->get(id, u);
+      pushOpen(createNewNode(child, g_cost, f_cost, n));
+    }
+  }
+
+  Path path;
+  if (!invalid) {  // success
+    while (n != nullptr) {
+      path.push_back(n->v);
+      n = n->p;
+    }
+    std::reverse(path.begin(), path.end());
+  }
+
+  return path;
+}
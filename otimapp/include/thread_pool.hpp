@@ -0,0 +1,82 @@
+/*
+ * fixed-size thread pool, runs one job on all workers at once
+ */
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+private:
+  std::vector<std::thread> workers;  // except for the caller
+  std::function<void(int)> job;      // job(worker_id)
+
+  std::mutex mtx;
+  std::condition_variable cv_start;
+  std::condition_variable cv_finish;
+  int generation;  // incremented at every job
+  int running;     // number of workers executing the job
+  bool stopping;
+
+  void loop(const int worker_id)
+  {
+    int seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv_start.wait(lk, [&] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+      }
+      job(worker_id);
+      {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (--running == 0) cv_finish.notify_one();
+      }
+    }
+  }
+
+public:
+  // the caller also works as worker 0
+  ThreadPool(const int threads_num)
+      : generation(0), running(0), stopping(false)
+  {
+    for (int k = 1; k < threads_num; ++k) {
+      workers.emplace_back([this, k] { loop(k); });
+    }
+  }
+
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      stopping = true;
+    }
+    cv_start.notify_all();
+    for (auto& th : workers) th.join();
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int size() const { return (int)workers.size() + 1; }
+
+  // execute f(worker_id) for all workers, return when all finish
+  void run(std::function<void(int)> f)
+  {
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      job = std::move(f);
+      running = (int)workers.size();
+      ++generation;
+    }
+    cv_start.notify_all();
+    job(0);
+    std::unique_lock<std::mutex> lk(mtx);
+    cv_finish.wait(lk, [&] { return running == 0; });
+  }
+};
@@ -1,6 +1,6 @@
 #include "../include/agent.hpp"
 
-Agent::Agent(int _id, const Path& _path)
+Agent::Agent(int _id, const Path& _path, const CSRGraph* csr)
     : id(_id),
       t(0),
       mode(Mode::CONTRACTED),
@@ -8,6 +8,9 @@ Agent::Agent(int _id, const Path& _path)
       tail(_path[0]),
       path(_path)
 {
+  for (auto v : path) {
+    path_index.push_back(csr != nullptr ? csr->getIndex(v) : v->id);
+  }
 }
 
 Node* Agent::getNextNode() const
@@ -15,6 +18,14 @@ Node* Agent::getNextNode() const
   return (t < (int)path.size() - 1) ? path[t + 1] : nullptr;
 }
 
+int Agent::getNextIndex() const { return path_index[t + 1]; }
+
+int Agent::getTailIndex() const
+{
+  // the tail is the previous node while extended
+  return (mode == Mode::EXTENDED) ? path_index[t - 1] : path_index[t];
+}
+
 bool Agent::isFinished() const
 {
   return mode == Mode::CONTRACTED && t == (int)path.size() - 1;
@@ -25,7 +36,10 @@ Agent::State Agent::getState() const
   return std::make_tuple(id, t, mode, head, tail);
 }
 
-MAPF_DP_Agent::MAPF_DP_Agent(int _id, const Path& _path) : Agent(_id, _path) {}
+MAPF_DP_Agent::MAPF_DP_Agent(int _id, const Path& _path, const CSRGraph* csr)
+    : Agent(_id, _path, csr)
+{
+}
 
 void MAPF_DP_Agent::activate(std::vector<int>& occupancy)
 {
@@ -33,37 +47,38 @@ void MAPF_DP_Agent::activate(std::vector<int>& occupancy)
 
   if (mode == Mode::EXTENDED) {
     // update occupancy
-    occupancy[tail->id] = NIL;
+    occupancy[getTailIndex()] = NIL;
     // update state
     mode = Mode::CONTRACTED;
     tail = head;
     head = nullptr;
   } else {
-    auto v = getNextNode();
-    if (occupancy[v->id] == NIL) {  // check occupancy
+    const int v = getNextIndex();
+    if (occupancy[v] == NIL) {  // check occupancy
       // update state
       mode = Mode::EXTENDED;
-      head = v;
+      head = getNextNode();
       t += 1;
       // update occupancy
-      occupancy[v->id] = id;
+      occupancy[v] = id;
     }
   }
 }
 
-PrimitiveAgent::PrimitiveAgent(int _id, const Path& _path) : Agent(_id, _path)
+PrimitiveAgent::PrimitiveAgent(int _id, const Path& _path, const CSRGraph* csr)
+    : Agent(_id, _path, csr)
 {
 }
 
 void PrimitiveAgent::activate(std::vector<int>& occupancy)
 {
   if (isFinished()) return;
-  auto v = getNextNode();
-  if (occupancy[v->id] == NIL) {
+  const int v = getNextIndex();
+  if (occupancy[v] == NIL) {
     // update state
-    occupancy[tail->id] = NIL;
-    tail = v;
-    occupancy[v->id] = id;
+    occupancy[getTailIndex()] = NIL;
+    tail = getNextNode();
+    occupancy[v] = id;
     t += 1;
   }
 }
@@ -0,0 +1,131 @@
+#include "../include/csr_graph.hpp"
+
+#include <algorithm>
+
+CSRGraph::CSRGraph(Graph* G, const Order _order)
+    : order(_order), index_of(G->getNodesSize(), -1)
+{
+  switch (order) {
+    case HILBERT:
+      nodes = getHilbertOrder(G);
+      break;
+    case RCM:
+      nodes = getRCMOrder(G);
+      break;
+    default:
+      nodes = G->getV();
+      break;
+  }
+  const int nodes_num = nodes.size();
+  for (int v = 0; v < nodes_num; ++v) {
+    if (nodes[v] != nullptr) index_of[nodes[v]->id] = v;
+  }
+
+  offsets.assign(nodes_num + 1, 0);
+  for (int v = 0; v < nodes_num; ++v) {
+    const int degree = (nodes[v] == nullptr) ? 0 : nodes[v]->neighbor.size();
+    offsets[v + 1] = offsets[v] + degree;
+  }
+  neighbors.reserve(offsets[nodes_num]);
+  for (auto v : nodes) {
+    if (v == nullptr) continue;
+    for (auto u : v->neighbor) neighbors.push_back(index_of[u->id]);
+  }
+  goals.assign((nodes_num + 63) / 64, 0);
+}
+
+CSRGraph::~CSRGraph() {}
+
+void CSRGraph::setGoals(const Nodes& config_g)
+{
+  std::fill(goals.begin(), goals.end(), 0);
+  for (auto v : config_g) {
+    const int k = getIndex(v);
+    goals[k >> 6] |= (uint64_t)1 << (k & 63);
+  }
+}
+
+CSRGraph::Order CSRGraph::getOrder(const std::string& name)
+{
+  if (name == "hilbert") return HILBERT;
+  if (name == "rcm") return RCM;
+  return ID;
+}
+
+// position of (x, y) on the Hilbert curve filling n x n, n is a power of two
+static uint64_t getHilbertIndex(const int n, int x, int y)
+{
+  uint64_t d = 0;
+  for (int s = n / 2; s > 0; s /= 2) {
+    const int rx = (x & s) > 0;
+    const int ry = (y & s) > 0;
+    d += (uint64_t)s * s * ((3 * rx) ^ ry);
+    // rotate the quadrant
+    if (ry == 0) {
+      if (rx == 1) {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+Nodes CSRGraph::getHilbertOrder(Graph* G)
+{
+  Nodes V;
+  int size = 1;
+  for (auto v : G->getV()) {
+    if (v == nullptr) continue;
+    V.push_back(v);
+    while (size <= std::max(v->pos.x, v->pos.y)) size *= 2;
+  }
+  std::vector<std::pair<uint64_t, Node*>> keys;
+  for (auto v : V) {
+    keys.emplace_back(getHilbertIndex(size, v->pos.x, v->pos.y), v);
+  }
+  std::stable_sort(keys.begin(), keys.end(),
+                   [](const std::pair<uint64_t, Node*>& a,
+                      const std::pair<uint64_t, Node*>& b) {
+                     return a.first < b.first;
+                   });
+  for (std::size_t k = 0; k < keys.size(); ++k) V[k] = keys[k].second;
+  return V;
+}
+
+Nodes CSRGraph::getRCMOrder(Graph* G)
+{
+  auto compareDegree = [](Node* a, Node* b) {
+    return a->getDegree() < b->getDegree();
+  };
+
+  // each component starts from the node with the smallest degree
+  Nodes V;
+  for (auto v : G->getV()) {
+    if (v != nullptr) V.push_back(v);
+  }
+  std::stable_sort(V.begin(), V.end(), compareDegree);
+
+  // breadth first search, children in ascending order of degrees
+  Nodes res;
+  Nodes children;
+  std::vector<bool> visited(G->getNodesSize(), false);
+  for (auto s : V) {
+    if (visited[s->id]) continue;
+    visited[s->id] = true;
+    res.push_back(s);
+    for (std::size_t head = res.size() - 1; head < res.size(); ++head) {
+      children.clear();
+      for (auto u : res[head]->neighbor) {
+        if (visited[u->id]) continue;
+        visited[u->id] = true;
+        children.push_back(u);
+      }
+      std::stable_sort(children.begin(), children.end(), compareDegree);
+      res.insert(res.end(), children.begin(), children.end());
+    }
+  }
+  std::reverse(res.begin(), res.end());
+  return res;
+}
@@ -0,0 +1,443 @@
+#include "../include/cycle_detector.hpp"
+
+#include <algorithm>
+#include <queue>
+
+#include "../include/util.hpp"
+
+// rebuild components when many edges are removed
+static constexpr int REBUILD_MIN_REMOVED = 1024;
+
+CycleDetector::CycleDetector(Graph* _G, const int _max_length)
+    : G(_G),
+      max_length(_max_length),
+      out_edges(G->getNodesSize()),
+      in_edges(G->getNodesSize()),
+      edges_num(0),
+      removed_num(0),
+      comp_parent(G->getNodesSize()),
+      comp_members(G->getNodesSize()),
+      ord(G->getNodesSize()),
+      stamp(G->getNodesSize(), 0),
+      stamp_cnt(0),
+      version(0),
+      bfs_from(-1),
+      bfs_agent(-1),
+      bfs_version(-1),
+      bfs_stamp(0),
+      search_lo(0),
+      node_stamp(G->getNodesSize(), 0),
+      node_agent(G->getNodesSize(), -1),
+      on_path(G->getNodesSize(), false),
+      next_moves(G->getNodesSize()),
+      nogoods(G->getNodesSize()),
+      agent_stamp_cnt(0)
+{
+  for (int v = 0; v < (int)G->getNodesSize(); ++v) {
+    comp_parent[v] = v;
+    comp_members[v] = {v};
+    ord[v] = v;
+  }
+}
+
+CycleDetector::~CycleDetector() {}
+
+int CycleDetector::findComp(int v)
+{
+  while (comp_parent[v] != v) {
+    comp_parent[v] = comp_parent[comp_parent[v]];
+    v = comp_parent[v];
+  }
+  return v;
+}
+
+void CycleDetector::updateOrder(const int from, const int to,
+                                std::vector<int>* absorbed)
+{
+  const int c_from = findComp(from);
+  const int c_to = findComp(to);
+  if (c_from == c_to || ord[c_from] < ord[c_to]) return;
+
+  // components between c_to and c_from in the current order are affected
+  const int lb = ord[c_to];
+  const int ub = ord[c_from];
+  std::vector<int> comps_forward, comps_backward, stack;
+
+  // forward search from c_to
+  const int stamp_forward = ++stamp_cnt;
+  bool cycle = false;
+  stamp[c_to] = stamp_forward;
+  comps_forward.push_back(c_to);
+  stack.push_back(c_to);
+  while (!stack.empty()) {
+    auto r = stack.back();
+    stack.pop_back();
+    for (auto v : comp_members[r]) {
+      for (auto e : out_edges[v]) {
+        auto w = findComp(edges[e].to);
+        if (stamp[w] == stamp_forward || ord[w] > ub) continue;
+        if (w == c_from) cycle = true;
+        stamp[w] = stamp_forward;
+        comps_forward.push_back(w);
+        stack.push_back(w);
+      }
+    }
+  }
+
+  // backward search from c_from
+  const int stamp_backward = ++stamp_cnt;
+  std::vector<int> comps_merged;  // on cycles, i.e., forward and backward
+  stamp[c_from] = stamp_backward;
+  comps_backward.push_back(c_from);
+  stack.push_back(c_from);
+  while (!stack.empty()) {
+    auto r = stack.back();
+    stack.pop_back();
+    for (auto v : comp_members[r]) {
+      for (auto e : in_edges[v]) {
+        auto w = findComp(edges[e].from);
+        if (stamp[w] == stamp_backward || ord[w] < lb) continue;
+        if (stamp[w] == stamp_forward) comps_merged.push_back(w);
+        stamp[w] = stamp_backward;
+        comps_backward.push_back(w);
+        stack.push_back(w);
+      }
+    }
+  }
+
+  // reuse the order of affected components
+  std::vector<int> pool;
+  for (auto r : comps_backward) pool.push_back(ord[r]);
+  for (auto r : comps_forward) {
+    if (stamp[r] != stamp_backward) pool.push_back(ord[r]);
+  }
+  std::sort(pool.begin(), pool.end());
+
+  // merge components on cycles
+  int c_merged = -1;
+  if (cycle) {
+    comps_merged.push_back(c_from);
+    c_merged = comps_merged.front();
+    for (auto r : comps_merged) {
+      if (comp_members[r].size() > comp_members[c_merged].size()) c_merged = r;
+    }
+    for (auto r : comps_merged) {
+      if (r == c_merged) continue;
+      if (absorbed != nullptr) {
+        absorbed->insert(absorbed->end(), comp_members[r].begin(),
+                         comp_members[r].end());
+      }
+      comp_parent[r] = c_merged;
+      comp_members[c_merged].insert(comp_members[c_merged].end(),
+                                    comp_members[r].begin(),
+                                    comp_members[r].end());
+      comp_members[r].clear();
+      comp_members[r].shrink_to_fit();
+    }
+  }
+
+  // backward -> merged -> forward
+  // forward components take the largest orders, since the pool has unused
+  // orders after merging and no component may precede its predecessors
+  auto compare = [&](int a, int b) { return ord[a] < ord[b]; };
+  auto isMerged = [&](int r) { return cycle && findComp(r) == c_merged; };
+  std::sort(comps_backward.begin(), comps_backward.end(), compare);
+  std::sort(comps_forward.begin(), comps_forward.end(), compare);
+  auto itr = pool.begin();
+  for (auto r : comps_backward) {
+    if (!isMerged(r)) ord[r] = *(itr++);
+  }
+  if (cycle) ord[c_merged] = *(itr++);
+  auto itr_rev = pool.rbegin();
+  for (auto r = comps_forward.rbegin(); r != comps_forward.rend(); ++r) {
+    if (!isMerged(*r)) ord[*r] = *(itr_rev++);
+  }
+}
+
+void CycleDetector::rebuild()
+{
+  auto old_edges = edges;
+  edges.clear();
+  for (auto& arr : out_edges) arr.clear();
+  for (auto& arr : in_edges) arr.clear();
+  for (auto& arr : agent_edges) arr.clear();
+  for (int v = 0; v < (int)G->getNodesSize(); ++v) {
+    comp_parent[v] = v;
+    comp_members[v] = {v};
+    ord[v] = v;
+  }
+  edges_num = 0;
+  removed_num = 0;
+
+  for (auto& e : old_edges) {
+    if (e.removed) continue;
+    const int id = edges.size();
+    edges.push_back(e);
+    out_edges[e.from].push_back(id);
+    in_edges[e.to].push_back(id);
+    agent_edges[e.agent].push_back(id);
+    ++edges_num;
+    updateOrder(e.from, e.to);
+  }
+}
+
+bool CycleDetector::addEdge(const int from, const int to, const int agent,
+                            std::vector<int>& path, std::vector<int>& agents)
+{
+  insertEdge(from, to, agent);
+  return findCycle(from, to, agent, path, agents);
+}
+
+void CycleDetector::insertEdge(const int from, const int to, const int agent,
+                               std::vector<int>* absorbed)
+{
+  const int id = edges.size();
+  edges.push_back({from, to, agent, false});
+  out_edges[from].push_back(id);
+  in_edges[to].push_back(id);
+  if (agent >= (int)agent_edges.size()) agent_edges.resize(agent + 1);
+  agent_edges[agent].push_back(id);
+  ++edges_num;
+  ++version;
+
+  updateOrder(from, to, absorbed);
+}
+
+bool CycleDetector::isSameComp(const int v, const int u)
+{
+  return findComp(v) == findComp(u);
+}
+
+void CycleDetector::searchBackward(const int goal, const int agent,
+                                   const int hi)
+{
+  // moves of the same agent cannot be consecutive
+  if (edge_stamp.size() < edges.size()) {
+    edge_stamp.resize(edges.size(), 0);
+    edge_dist.resize(edges.size(), 0);
+  }
+  ++bfs_stamp;
+  std::queue<int> OPEN;
+  auto isValidEdge = [&](const int e) {
+    if (edges[e].agent == agent || edge_stamp[e] == bfs_stamp) return false;
+    return ord[findComp(edges[e].from)] <= hi;
+  };
+  for (auto e : in_edges[goal]) {
+    if (!isValidEdge(e)) continue;
+    edge_stamp[e] = bfs_stamp;
+    edge_dist[e] = 1;
+    OPEN.push(e);
+  }
+  while (!OPEN.empty()) {
+    auto e = OPEN.front();
+    OPEN.pop();
+    auto v = edges[e].from;
+    if (max_length != -1 && edge_dist[e] + 2 > max_length) continue;
+    // expand each node at most twice, by moves of two distinct agents
+    if (node_stamp[v] != bfs_stamp) {
+      node_stamp[v] = bfs_stamp;
+      node_agent[v] = edges[e].agent;
+    } else if (node_agent[v] != -1 && node_agent[v] != edges[e].agent) {
+      node_agent[v] = -1;
+    } else {
+      continue;
+    }
+    for (auto f : in_edges[v]) {
+      if (!isValidEdge(f) || edges[f].agent == edges[e].agent) continue;
+      edge_stamp[f] = bfs_stamp;
+      edge_dist[f] = edge_dist[e] + 1;
+      OPEN.push(f);
+    }
+  }
+}
+
+bool CycleDetector::findCycle(const int from, const int to, const int agent,
+                              std::vector<int>& path, std::vector<int>& agents)
+{
+  path.clear();
+  agents.clear();
+
+  // staying is regarded as a cycle
+  if (from == to) {
+    path = {from, to};
+    agents = {agent};
+    return true;
+  }
+  if (max_length == 1) return false;
+
+  // any path to -> from stays between two components in the order
+  const int lo = ord[findComp(to)];
+  const int hi = ord[findComp(from)];
+  if (lo > hi) return false;
+
+  search_lo = lo;
+  ++stamp_cnt;
+
+  // moves which can reach the goal, reused while the graph is unchanged
+  if (bfs_from != from || bfs_agent != agent || bfs_version != version) {
+    searchBackward(from, agent, hi);
+    bfs_from = from;
+    bfs_agent = agent;
+    bfs_version = version;
+  }
+  bool reachable = false;
+  for (auto e : out_edges[to]) {
+    if (edge_stamp[e] == bfs_stamp) {
+      reachable = true;
+      break;
+    }
+  }
+  if (!reachable) return false;
+
+  // depth first search of simple paths, agents are assigned by matching
+  const int agents_num = std::max((int)agent_edges.size(), agent + 1);
+  if ((int)agent_step.size() < agents_num) {
+    agent_step.resize(agents_num, -1);
+    agent_stamp.resize(agents_num, 0);
+  }
+  path = {from, to};
+  step_agent = {agent};
+  agent_step[agent] = 0;
+  on_path[to] = true;
+  auto res = searchCycle(to, from, path);
+  on_path[to] = false;
+  for (auto i : step_agent) {
+    if (i != -1) agent_step[i] = -1;
+  }
+  if (res) {
+    agents.assign(step_agent.begin(), step_agent.begin() + path.size() - 1);
+  } else {
+    path.clear();
+  }
+  return res;
+}
+
+bool CycleDetector::assignAgent(const int step)
+{
+  for (auto i : candidates[step]) {
+    if (agent_stamp[i] == agent_stamp_cnt) continue;
+    agent_stamp[i] = agent_stamp_cnt;
+    if (agent_step[i] == -1 || assignAgent(agent_step[i])) {
+      agent_step[i] = step;
+      step_agent[step] = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CycleDetector::searchCycle(const int v, const int goal,
+                                std::vector<int>& path)
+{
+  if (v == goal) return true;
+
+  const int step = path.size() - 1;  // move from v
+  if ((int)candidates.size() <= step) candidates.resize(step + 1);
+  if ((int)step_agent.size() <= step) step_agent.resize(step + 1, -1);
+
+  // moves from v grouped by destinations
+  auto& moves = next_moves[v];
+  moves.clear();
+  for (auto e : out_edges[v]) {
+    // moves which cannot reach the goal are not stamped
+    if (edge_stamp[e] != bfs_stamp) continue;
+    if (ord[findComp(edges[e].to)] < search_lo) continue;
+    moves.push_back(e);
+  }
+  std::sort(moves.begin(), moves.end(),
+            [&](int a, int b) { return edges[a].to < edges[b].to; });
+
+  // conditions of failure, only nodes before v are relevant
+  std::vector<int> blocking_nodes;
+  bool blocking_length = false;
+  bool blocking_agents = false;  // failed by matching, not recordable
+  auto addNogood = [&](const int u) {
+    auto& ng = nogoods[u];
+    if (ng.stamp != stamp_cnt) {
+      blocking_agents = true;
+      return;
+    }
+    for (auto w : ng.nodes) {
+      if (w != u && !inArray(w, blocking_nodes)) blocking_nodes.push_back(w);
+    }
+    if (ng.length > 0) blocking_length = true;
+  };
+
+  for (int k = 0; k < (int)moves.size();) {
+    const int u = edges[moves[k]].to;
+    int dist = max_length;  // minimum number of moves to the goal
+    candidates[step].clear();
+    for (; k < (int)moves.size() && edges[moves[k]].to == u; ++k) {
+      candidates[step].push_back(edges[moves[k]].agent);
+      dist = std::min(dist, edge_dist[moves[k]]);
+    }
+
+    if (on_path[u]) {
+      if (!inArray(u, blocking_nodes)) blocking_nodes.push_back(u);
+      continue;
+    }
+    if (max_length != -1 && step + dist > max_length) {
+      blocking_length = true;
+      continue;
+    }
+
+    // failed before under the same conditions
+    auto& ng = nogoods[u];
+    if (ng.stamp == stamp_cnt && step + 1 >= ng.length &&
+        std::all_of(ng.nodes.begin(), ng.nodes.end(),
+                    [&](int w) { return w == u || on_path[w]; })) {
+      addNogood(u);
+      continue;
+    }
+
+    // distinct agents for all moves
+    ++agent_stamp_cnt;
+    if (!assignAgent(step)) {
+      blocking_agents = true;
+      continue;
+    }
+
+    path.push_back(u);
+    on_path[u] = true;
+    auto res = searchCycle(u, goal, path);
+    on_path[u] = false;
+    if (res) return true;
+    path.pop_back();
+    agent_step[step_agent[step]] = -1;
+    step_agent[step] = -1;
+    addNogood(u);
+  }
+
+  // record the conditions
+  auto& ng = nogoods[v];
+  if (blocking_agents) {
+    ng.stamp = 0;
+  } else {
+    ng.stamp = stamp_cnt;
+    ng.nodes = blocking_nodes;
+    ng.length = blocking_length ? step : 0;
+  }
+  return false;
+}
+
+void CycleDetector::removeAgent(const int agent)
+{
+  if (agent >= (int)agent_edges.size()) return;
+
+  // components and the order remain valid
+  for (auto e : agent_edges[agent]) {
+    auto& edge = edges[e];
+    edge.removed = true;
+    auto& arr_out = out_edges[edge.from];
+    arr_out.erase(std::find(arr_out.begin(), arr_out.end(), e));
+    auto& arr_in = in_edges[edge.to];
+    arr_in.erase(std::find(arr_in.begin(), arr_in.end(), e));
+    --edges_num;
+    ++removed_num;
+  }
+  agent_edges[agent].clear();
+  ++version;
+
+  // but components become coarse
+  if (removed_num > REBUILD_MIN_REMOVED && removed_num > edges_num) rebuild();
+}
@@ -2,7 +2,15 @@
 
 const std::string DBS::SOLVER_NAME = "DBS";
 
-DBS::DBS(Problem* _P) : Solver(_P), max_fragment_size(DEFAULT_MAX_FRAGMENT_SIZE)
+DBS::DBS(Problem* _P)
+    : Solver(_P),
+      max_fragment_size(DEFAULT_MAX_FRAGMENT_SIZE),
+      detection_threads(DEFAULT_DETECTION_THREADS),
+      cycle_detection(false),
+      scc_pruning(false),
+      fragments_limit(-1),
+      memory_budget(0),
+      registered_num(0)
 {
   solver_name = SOLVER_NAME;
 }
@@ -21,6 +29,10 @@ void DBS::run()
   std::priority_queue<HighLevelNode_p, HighLevelNodes, decltype(compare)> Tree(
       compare);
 
+  // table shared by all high-level nodes, created in getConstraints
+  table.reset();
+  table_paths.resize(P->getNum());
+
   // initial node
   auto n = getInitialNode();
   if (!n->valid) {
@@ -32,6 +44,7 @@ void DBS::run()
   // start high-level search
   int h_node_num = 1;
   int iteration = 0;
+  bool timeout = false;
   while (!Tree.empty()) {
     ++iteration;
 
@@ -41,25 +54,28 @@ void DBS::run()
 
     info(" ", "elapsed:", getSolverElapsedTime(),
          ", explored_node_num:", iteration, ", nodes_num:", h_node_num,
-         ", constraints:", n->constraints.size(), ", head-collision:", n->f);
+         ", constraints:", n->constraints_num, ", head-collision:", n->f);
 
     // check conflict
-    auto constraints = getConstraints(n->paths);
+    auto paths = getPaths(n);
+    auto constraints = getConstraints(paths);
 
     // check limitation
     if (overCompTime()) {
       info(" ", "timeout");
+      timeout = true;
       break;
     }
 
     if (constraints.empty()) {
       solved = true;
+      solution = paths;
       break;
     }
 
     // create new nodes
     for (auto c : constraints) {
-      auto m = invoke(n, c);
+      auto m = invoke(n, c, paths);
       if (m->valid) {
         Tree.push(m);
         ++h_node_num;
@@ -67,12 +83,16 @@ void DBS::run()
     }
   }
 
-  if (solved) {
-    solution = n->paths;
-  } else if (Tree.empty()) {
+  // the popped node is not expanded when timeout
+  if (!solved && !timeout && Tree.empty()) {
     info(" ", "unsolvable instance");
     unsolvable = true;
   }
+
+  // release the table and its journal
+  if (table != nullptr) fragment_stats.merge(table->getStats());
+  table.reset();
+  checkpoints.clear();
 }
 
 DBS::HighLevelNode_p DBS::getInitialNode()
@@ -80,7 +100,10 @@ DBS::HighLevelNode_p DBS::getInitialNode()
   auto n = std::make_shared<HighLevelNode>();
 
   // to manage potential deadlocks
-  auto table = new TableFragment(G, max_fragment_size);
+  auto table = new TableFragment(G, max_fragment_size, csr);
+  setupTable(table);
+  // the tie-break of A* counts all fragments
+  table->setSccPruning(false);
 
   for (int i = 0; i < P->getNum(); ++i) {
     // find a deadlock-free path as much as possible
@@ -92,7 +115,7 @@ DBS::HighLevelNode_p DBS::getInitialNode()
     if (p.empty()) {
       // returns a path with potential deadlocks
       auto t_p = Time::now();
-      p = getConstrainedPath(i, n);
+      p = getConstrainedPath(i, n, n->paths);
       elapsed_time_pathfinding += getElapsedTime(t_p);
       // fail to find a path
       if (p.empty()) {
@@ -104,11 +127,20 @@ DBS::HighLevelNode_p DBS::getInitialNode()
 
     // update tables
     auto t_d = Time::now();
-    table->registerNewPath(i, p, true, getRemainedTime());
+    table->registerNewPath(i, p, true, &deadline);
     elapsed_time_deadlock_detection += getElapsedTime(t_d);
+
+    // fail fast
+    if (table->isOverLimit()) {
+      info("  ", "exceed the limit of fragments");
+      cancel();
+      n->valid = false;
+      break;
+    }
   }
 
   auto t_d = Time::now();
+  fragment_stats.merge(table->getStats());
   delete table;
   elapsed_time_deadlock_detection += getElapsedTime(t_d);
 
@@ -117,42 +149,65 @@ DBS::HighLevelNode_p DBS::getInitialNode()
   return n;
 }
 
-DBS::HighLevelNode_p DBS::invoke(HighLevelNode_p n, Constraint_p c)
+DBS::HighLevelNode_p DBS::invoke(HighLevelNode_p n, Constraint_p c,
+                                 const Plan& paths)
 {
   auto m = std::make_shared<HighLevelNode>();
 
   // setup constraints
-  m->constraints = n->constraints;
-  m->constraints.push_back(c);
+  m->parent = n;
+  m->constraint = c;
+  m->constraints_num = n->constraints_num + 1;
 
   // create new solution
-  m->paths = n->paths;
   auto t_d = Time::now();
-  m->paths[c->agent] = getConstrainedPath(c->agent, m);
+  m->path = getConstrainedPath(c->agent, m, paths);
   elapsed_time_deadlock_detection += getElapsedTime(t_d);
 
   // failed to find a path
-  m->valid = !m->paths[c->agent].empty();
+  m->valid = !m->path.empty();
 
   // count head-on collisions
-  m->f = countsSwapConlicts(m->paths);
+  if (m->valid) {
+    auto new_paths = paths;
+    new_paths[c->agent] = m->path;
+    m->f = countsSwapConlicts(new_paths);
+  }
 
   return m;
 }
 
-Path DBS::getConstrainedPath(const int id, HighLevelNode_p node)
+Plan DBS::getPaths(HighLevelNode_p node) const
+{
+  // the newest path of each agent is closest to the node
+  std::vector<HighLevelNode*> updated(P->getNum(), nullptr);
+  auto n = node.get();
+  for (; n->parent != nullptr; n = n->parent.get()) {
+    if (updated[n->constraint->agent] == nullptr) {
+      updated[n->constraint->agent] = n;
+    }
+  }
+  Plan paths = n->paths;
+  for (int i = 0; i < P->getNum(); ++i) {
+    if (updated[i] != nullptr) paths[i] = updated[i]->path;
+  }
+  return paths;
+}
+
+Path DBS::getConstrainedPath(const int id, HighLevelNode_p node,
+                             const Plan& paths)
 {
   Node* const g = P->getGoal(id);
 
   // extract relevant constraints
   Constraints constraints;
-  for (auto c : node->constraints) {
-    if (c->agent == id) constraints.push_back(c);
+  for (auto n = node.get(); n->parent != nullptr; n = n->parent.get()) {
+    if (n->constraint->agent == id) constraints.push_back(n->constraint);
   }
 
   auto checkInvalidMove = [&](Node* child, Node* parent) {
     // condition 1, avoid goals
-    if (child != g && table_goals[child->id]) return true;
+    if (child != g && csr->isGoal(child)) return true;
     // condition 2, follow constraints
     for (auto c : constraints) {
       if (c->child == child && c->parent == parent) return true;
@@ -162,21 +217,22 @@ Path DBS::getConstrainedPath(const int id, HighLevelNode_p node)
 
   // for tie-breaking
   std::vector<std::vector<int>> from_to_table(G->getNodesSize());
-  for (int i = 0; i < (int)node->paths.size(); ++i) {
+  for (int i = 0; i < (int)paths.size(); ++i) {
     if (i == id) continue;
-    auto p = node->paths[i];
+    auto& p = paths[i];
     for (int t = 1; t < (int)p.size(); ++t) {
       from_to_table[p[t - 1]->id].push_back(p[t]->id);
     }
   }
 
   auto compare = [&](AstarNode* a, AstarNode* b) {
-    // greedy search
-    if (pathDist(id, a->v) != pathDist(id, b->v))
-      return pathDist(id, a->v) > pathDist(id, b->v);
+    // greedy search, f - g is the distance to the goal
+    const int h_a = a->f - a->g;
+    const int h_b = b->f - b->g;
+    if (h_a != h_b) return h_a > h_b;
     // tie break, avoid swap conflicts
-    auto table_a = from_to_table[a->p->v->id];
-    auto table_b = from_to_table[b->p->v->id];
+    const auto& table_a = from_to_table[a->p->v->id];
+    const auto& table_b = from_to_table[b->p->v->id];
     bool swap_a =
         std::find(table_a.begin(), table_a.end(), a->v->id) != table_a.end();
     bool swap_b =
@@ -187,35 +243,68 @@ Path DBS::getConstrainedPath(const int id, HighLevelNode_p node)
     return false;
   };
 
+  // buckets of distances to the goal, the comparator breaks ties
+  auto getKey = [](AstarNode* a) { return a->f - a->g; };
+
   // use A-star search
-  return Solver::getPath(id, checkInvalidMove, compare);
+  return getPathWithPolicy(id, checkInvalidMove, compare, getKey);
 }
 
 DBS::Constraints DBS::getConstraints(const Plan& paths)
 {
   Constraints constraints = {};
-  auto table = new TableFragment(G, max_fragment_size);
+  auto t_d = Time::now();
 
-  // main loop
-  for (int i = 0; i < P->getNum(); ++i) {
-    auto t_d = Time::now();
-    auto c = table->registerNewPath(i, paths[i], false, getRemainedTime());
-    elapsed_time_deadlock_detection += getElapsedTime(t_d);
-    // found potential deadlocks
-    if (c != nullptr) {
-      // create constraints
-      for (int i = 0; i < (int)c->agents.size(); ++i) {
-        constraints.push_back(std::make_shared<Constraint>(
-            c->agents[i], c->path[i], c->path[i + 1]));
-      }
-      break;
-    }
+  // synchronize the table with the paths, the table becomes identical to a
+  // new one with the same prefix, so the first potential deadlock is the
+  // same as building the table from scratch
+  const bool use_checkpoints = !cycle_detection && !scc_pruning;
+  int k = 0;
+  if (use_checkpoints) {
+    while (k < registered_num && table_paths[k] == paths[k]) ++k;
+  }
+  if (k == 0) {
+    // build from scratch, cheaper than undoing all changes, also releases
+    // the journal and the arena
+    if (table != nullptr) fragment_stats.merge(table->getStats());
+    table = std::make_unique<TableFragment>(G, max_fragment_size, csr);
+    setupTable(table.get());
+    checkpoints.clear();
+  } else if (k < (int)checkpoints.size()) {
+    table->rollback(checkpoints[k]);
+    checkpoints.resize(k);
+  }
+  registered_num = k;
+
+  // register paths until finding the first potential deadlock
+  Fragment* c = nullptr;
+  for (int i = k; i < P->getNum(); ++i) {
+    if (deadline.expired()) break;
+    if (use_checkpoints) checkpoints.push_back(table->getCheckpoint());
+    c = table->registerNewPath(i, paths[i], false, &deadline);
+    table_paths[i] = paths[i];
+    // interrupted registration has already marked the deadline as expired
+    if (c != nullptr || table->isOverLimit() || deadline.expired()) break;
+    ++registered_num;
   }
-
-  auto t_d = Time::now();
-  delete table;
   elapsed_time_deadlock_detection += getElapsedTime(t_d);
 
+  // fail fast
+  if (table->isOverLimit()) {
+    info(" ", "exceed the limit of fragments");
+    cancel();
+    return constraints;
+  }
+
+  // found potential deadlocks
+  if (c != nullptr) {
+    // create constraints
+    for (int i = 0; i < (int)c->agents.size(); ++i) {
+      constraints.push_back(std::make_shared<Constraint>(
+          c->agents[i], G->getNode(c->path[i]), G->getNode(c->path[i + 1])));
+    }
+  }
+
   return constraints;
 }
 
@@ -238,19 +327,69 @@ int DBS::countsSwapConlicts(const Plan& paths)
   return cnt;
 }
 
+void DBS::setupTable(TableFragment* table) const
+{
+  table->setThreadsNum(detection_threads);
+  table->setCycleDetection(cycle_detection);
+  table->setSccPruning(scc_pruning);
+  table->setFragmentsLimit(fragments_limit);
+  table->setMemoryBudget((std::size_t)memory_budget << 20);
+}
+
 void DBS::setParams(int argc, char* argv[])
 {
   struct option longopts[] = {
       {"max-fragment-size", required_argument, 0, 'f'},
+      {"detection-threads", required_argument, 0, 'd'},
+      {"cycle-detection", no_argument, 0, 'c'},
+      {"scc-pruning", no_argument, 0, 'g'},
+      {"fragments-limit", required_argument, 0, 'l'},
+      {"memory-budget", required_argument, 0, 'b'},
+      {"distance-threads", required_argument, 0, 't'},
+      {"bit-parallel-bfs", no_argument, 0, 'w'},
+      {"compact-distance", no_argument, 0, 'z'},
+      {"lazy-distance", no_argument, 0, 'y'},
+      {"distance-cache", required_argument, 0, 'a'},
       {0, 0, 0, 0},
   };
   optind = 1;  // reset
   int opt, longindex;
-  while ((opt = getopt_long(argc, argv, "f:", longopts, &longindex)) != -1) {
+  while ((opt = getopt_long(argc, argv, "f:d:cgl:b:t:wzya:", longopts,
+                            &longindex)) != -1) {
     switch (opt) {
       case 'f':
         max_fragment_size = std::atoi(optarg);
         break;
+      case 'd':
+        detection_threads = std::atoi(optarg);
+        break;
+      case 'c':
+        cycle_detection = true;
+        break;
+      case 'g':
+        scc_pruning = true;
+        break;
+      case 'l':
+        fragments_limit = std::atoi(optarg);
+        break;
+      case 'b':
+        memory_budget = std::atoi(optarg);
+        break;
+      case 't':
+        distance_threads = std::atoi(optarg);
+        break;
+      case 'w':
+        bit_parallel_bfs = true;
+        break;
+      case 'z':
+        compact_distance = true;
+        break;
+      case 'y':
+        lazy_distance = true;
+        break;
+      case 'a':
+        distance_cache = std::string(optarg);
+        break;
       default:
         break;
     }
@@ -265,5 +404,70 @@ void DBS::printHelp()
             << "        "
             << "maximum fragment size"
 
+            << "\n"
+
+            << "  -d --detection-threads"
+            << "        "
+            << "threads for deadlock detection"
+
+            << "\n"
+
+            << "  -c --cycle-detection"
+            << "          "
+            << "detect cycles without enumerating fragments"
+
+            << "\n"
+
+            << "  -g --scc-pruning"
+            << "              "
+            << "create fragments only inside SCCs when finding constraints"
+
+            << "\n"
+
+            << "  -l --fragments-limit"
+            << "          "
+            << "fail when the number of fragments reaches this"
+
+            << "\n"
+
+            << "  -b --memory-budget"
+            << "            "
+            << "fail when fragments use this memory (MB)"
+
+            << "\n"
+
+            << "  -t --distance-threads"
+            << "         "
+            << "threads for creating the distance table"
+
+            << "\n"
+
+            << "  -w --bit-parallel-bfs"
+            << "         "
+            << "create the distance table by 64 searches at once"
+
+            << "\n"
+
+            << "  -z --compact-distance"
+            << "         "
+            << "store distances as 16-bit integers"
+
+            << "\n"
+
+            << "  -y --lazy-distance"
+            << "            "
+            << "compute distances of each goal when first used"
+
+            << "\n"
+
+            << "  -a --distance-cache"
+            << "           "
+            << "load and store distances in the directory"
+
+            << "\n"
+
+            << "  high-level nodes share one fragment table by rollback,\n"
+            << "  with -c or -g, the table is rebuilt for each node"
+
             << std::endl;
 }
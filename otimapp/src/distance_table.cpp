@@ -0,0 +1,386 @@
+#include "../include/distance_table.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <unordered_map>
+
+#include "../include/thread_pool.hpp"
+
+// header of cache files, followed by distances of all nodes
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t elem_size;  // bytes of each distance
+  int32_t nodes_num;
+  int32_t goal;  // node id
+  uint64_t graph_hash;
+};
+static constexpr uint32_t CACHE_MAGIC = 0x5444544f;  // "OTDT"
+
+// mkdir -p, false -> failed
+static bool makeDirectories(const std::string& dir)
+{
+  for (std::size_t pos = dir.find('/', 1);; pos = dir.find('/', pos + 1)) {
+    const auto path = dir.substr(0, pos);
+    if (mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    if (pos == std::string::npos) return true;
+  }
+}
+
+// read exactly size bytes, false -> error or end of file
+static bool readAll(const int fd, void* buf, std::size_t size)
+{
+  auto p = (char*)buf;
+  while (size > 0) {
+    const auto n = read(fd, p, size);
+    if (n <= 0) {
+      if (n == -1 && errno == EINTR) continue;
+      return false;
+    }
+    p += n;
+    size -= n;
+  }
+  return true;
+}
+
+DistanceTable::DistanceTable(Problem* _P, const bool _compact,
+                             const bool _lazy, const std::string& _cache_dir)
+    : P(_P),
+      csr(_P->getCSR()),
+      nodes_num(csr->getNodesSize()),
+      compact(_compact && isCompactAvailable(csr)),
+      lazy(_lazy),
+      cache_dir(_cache_dir),
+      graph_hash(_cache_dir.empty() ? 0 : getGraphHash(csr)),
+      agent_row(P->getNum()),
+      slots_num(0)
+{
+  // agents sharing a goal share a row
+  std::unordered_map<int, int> goal_row;
+  for (int i = 0; i < P->getNum(); ++i) {
+    const int g = csr->getIndex(P->getGoal(i));
+    auto res = goal_row.emplace(g, goals.size());
+    agent_row[i] = res.first->second;
+    if (res.second) goals.push_back(g);
+  }
+  row_slot.assign(goals.size(), -1);
+
+  // the table works without cache
+  if (!cache_dir.empty() && !makeDirectories(cache_dir)) {
+    std::cout << "warn@ DistanceTable: cannot create " << cache_dir
+              << std::endl;
+  }
+
+  // storage of lazy mode grows row by row
+  if (!lazy) {
+    const std::size_t size = (std::size_t)getRowsNum() * nodes_num;
+    if (compact) {
+      data_compact.reserve(size);
+    } else {
+      data.reserve(size);
+    }
+    for (int row = 0; row < getRowsNum(); ++row) allocateRow(row);
+  }
+}
+
+DistanceTable::~DistanceTable() {}
+
+bool DistanceTable::isCompactAvailable(const CSRGraph* csr)
+{
+  // ids of obstacles of grids are not used
+  int cnt = 0;
+  for (int v = 0; v < csr->getNodesSize(); ++v) {
+    if (csr->getNode(v) != nullptr) ++cnt;
+  }
+  return cnt < UNREACHABLE_COMPACT;
+}
+
+void DistanceTable::allocateRow(const int row)
+{
+  row_slot[row] = slots_num++;
+  const std::size_t size = (std::size_t)slots_num * nodes_num;
+  if (compact) {
+    data_compact.resize(size, UNREACHABLE_COMPACT);
+  } else {
+    data.resize(size, nodes_num);
+  }
+}
+
+void DistanceTable::create(const int threads_num, const bool bit_parallel,
+                           Deadline* deadline)
+{
+  if (lazy) return;
+
+  // rows in the cache are not searched
+  std::vector<int> rows;
+  for (int row = 0; row < getRowsNum(); ++row) {
+    if (!loadRow(row)) rows.push_back(row);
+  }
+
+  // bit-parallel search shares frontiers when goals are close to each other
+  if (bit_parallel) rows = groupRowsByGoals(rows, 64);
+
+  // each thread takes rows one by one, or 64 rows with bit-parallel search,
+  // with its own buffer
+  const int unit = bit_parallel ? 64 : 1;
+  const int units_num = (rows.size() + unit - 1) / unit;
+  std::atomic<int> next(0);
+  auto job = [&](const int worker_id) {
+    BfsBuffer buf;
+    for (int k = next++; k < units_num; k = next++) {
+      // the solver stops immediately after this anyway
+      if (deadline != nullptr && deadline->expiredNow()) break;
+
+      if (bit_parallel) {
+        const int num = std::min(unit, (int)rows.size() - k * unit);
+        if (compact) {
+          searchDistanceBitParallel(&rows[k * unit], num, data_compact.data(),
+                                    buf);
+        } else {
+          searchDistanceBitParallel(&rows[k * unit], num, data.data(), buf);
+        }
+        for (int j = 0; j < num; ++j) storeRow(rows[k * unit + j]);
+      } else {
+        if (compact) {
+          searchDistance(rows[k], data_compact.data(), buf);
+        } else {
+          searchDistance(rows[k], data.data(), buf);
+        }
+        storeRow(rows[k]);
+      }
+    }
+  };
+  const int workers_num = std::min(threads_num, units_num);
+  if (workers_num <= 1) {
+    job(0);
+  } else {
+    ThreadPool pool(workers_num);
+    pool.run(job);
+  }
+}
+
+int DistanceTable::computeRow(const int row)
+{
+  allocateRow(row);
+  if (loadRow(row)) return row_slot[row];
+  if (compact) {
+    searchDistance(row, data_compact.data(), buf_lazy);
+  } else {
+    searchDistance(row, data.data(), buf_lazy);
+  }
+  storeRow(row);
+  return row_slot[row];
+}
+
+uint64_t DistanceTable::getGraphHash(const CSRGraph* csr)
+{
+  // FNV-1a over node ids and neighbors
+  uint64_t h = 14695981039346656037ULL;
+  auto add = [&h](const int x) {
+    for (int k = 0; k < 4; ++k) {
+      h ^= (x >> (8 * k)) & 0xff;
+      h *= 1099511628211ULL;
+    }
+  };
+  add(csr->getNodesSize());
+  for (int v = 0; v < csr->getNodesSize(); ++v) {
+    if (csr->getNode(v) == nullptr) continue;
+    add(v);
+    add(csr->getNeighbors(v).size());
+    for (auto u : csr->getNeighbors(v)) add(u);
+  }
+  return h;
+}
+
+std::string DistanceTable::getCacheFileName(const int row) const
+{
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)graph_hash);
+  return cache_dir + "/" + hash + "_" + std::to_string(goals[row]) +
+         (compact ? ".d16" : ".d32");
+}
+
+bool DistanceTable::loadRow(const int row)
+{
+  if (cache_dir.empty()) return false;
+
+  const int fd = open(getCacheFileName(row).c_str(), O_RDONLY);
+  if (fd == -1) return false;
+  const std::size_t elem_size = compact ? sizeof(uint16_t) : sizeof(int);
+  const std::size_t size = elem_size * nodes_num;
+  struct stat st;
+  CacheHeader header;
+  bool valid = fstat(fd, &st) == 0 &&
+               (std::size_t)st.st_size == sizeof(CacheHeader) + size &&
+               readAll(fd, &header, sizeof(header)) &&
+               header.magic == CACHE_MAGIC && header.elem_size == elem_size &&
+               header.nodes_num == nodes_num && header.goal == goals[row] &&
+               header.graph_hash == graph_hash;
+
+  // distances are read into the row directly
+  if (valid) {
+    const std::size_t offset = (std::size_t)row_slot[row] * nodes_num;
+    if (compact) {
+      valid = readAll(fd, &data_compact[offset], size);
+      if (!valid) {
+        std::fill_n(&data_compact[offset], nodes_num, UNREACHABLE_COMPACT);
+      }
+    } else {
+      valid = readAll(fd, &data[offset], size);
+      if (!valid) std::fill_n(&data[offset], nodes_num, nodes_num);
+    }
+  }
+  close(fd);
+  return valid;
+}
+
+void DistanceTable::storeRow(const int row) const
+{
+  if (cache_dir.empty()) return;
+
+  // readers never see a partial file, rows are identical when written twice
+  // a unique temporary file for each writer, including threads and solvers
+  // in the same process
+  const auto file_name = getCacheFileName(row);
+  std::string tmp_name = file_name + ".XXXXXX";
+  const int fd = mkstemp(&tmp_name[0]);
+  if (fd == -1) return;
+  fchmod(fd, 0644);
+  FILE* fp = fdopen(fd, "wb");
+  if (fp == nullptr) {
+    close(fd);
+    std::remove(tmp_name.c_str());
+    return;
+  }
+  const std::size_t elem_size = compact ? sizeof(uint16_t) : sizeof(int);
+  const CacheHeader header{CACHE_MAGIC, (uint32_t)elem_size, nodes_num,
+                           goals[row], graph_hash};
+  const std::size_t offset = (std::size_t)row_slot[row] * nodes_num;
+  const void* src = compact ? (const void*)&data_compact[offset]
+                            : (const void*)&data[offset];
+  const std::size_t num = nodes_num;
+  bool ok = std::fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            std::fwrite(src, elem_size, num, fp) == num;
+  ok = (std::fclose(fp) == 0) && ok;
+  if (!ok || std::rename(tmp_name.c_str(), file_name.c_str()) != 0) {
+    std::remove(tmp_name.c_str());
+  }
+}
+
+template <typename T>
+void DistanceTable::searchDistance(const int row, T* storage, BfsBuffer& buf)
+{
+  T* dist = storage + (std::size_t)row_slot[row] * nodes_num;
+  auto& OPEN = buf.OPEN;  // FIFO, from head
+  OPEN.clear();
+  OPEN.push_back(goals[row]);
+  dist[goals[row]] = 0;
+  for (std::size_t head = 0; head < OPEN.size(); ++head) {
+    const int n = OPEN[head];
+    const int d_n = dist[n];
+    for (auto m : csr->getNeighbors(n)) {
+      const int d_m = dist[m];
+      if (d_n + 1 >= d_m) continue;
+      dist[m] = d_n + 1;
+      OPEN.push_back(m);
+    }
+  }
+}
+
+std::vector<int> DistanceTable::groupRowsByGoals(const std::vector<int>& rows,
+                                                 const int group_size)
+{
+  std::unordered_map<int, int> goal_row;  // not grouped yet
+  for (auto row : rows) goal_row.emplace(goals[row], row);
+
+  // each group collects nearest goals by breadth first search
+  std::vector<int> res;
+  std::vector<int> visited(nodes_num, -1);  // group id
+  std::vector<int> OPEN;
+  for (auto row : rows) {
+    const int g = goals[row];
+    if (goal_row.find(g) == goal_row.end()) continue;
+    const int group = res.size();
+    OPEN.clear();
+    OPEN.push_back(g);
+    visited[g] = group;
+    for (std::size_t head = 0; head < OPEN.size(); ++head) {
+      const int n = OPEN[head];
+      auto itr = goal_row.find(n);
+      if (itr != goal_row.end()) {
+        res.push_back(itr->second);
+        goal_row.erase(itr);
+        if ((int)res.size() - group == group_size) break;
+      }
+      for (auto m : csr->getNeighbors(n)) {
+        if (visited[m] == group) continue;
+        visited[m] = group;
+        OPEN.push_back(m);
+      }
+    }
+  }
+  return res;
+}
+
+template <typename T>
+void DistanceTable::searchDistanceBitParallel(const int* rows, const int num,
+                                              T* storage, BfsBuffer& buf)
+{
+  // frontier and next are cleared while searching
+  if ((int)buf.visited.size() != nodes_num) {
+    buf.frontier.assign(nodes_num, 0);
+    buf.next.assign(nodes_num, 0);
+  }
+  buf.visited.assign(nodes_num, 0);
+
+  // distances are written to rows directly, not buffered for each node
+  T* row_ptrs[64];
+  for (int k = 0; k < num; ++k) {
+    row_ptrs[k] = storage + (std::size_t)row_slot[rows[k]] * nodes_num;
+  }
+
+  auto& frontier_nodes = buf.OPEN;
+  frontier_nodes.clear();
+  for (int k = 0; k < num; ++k) {
+    const int g = goals[rows[k]];
+    if (buf.frontier[g] == 0) frontier_nodes.push_back(g);
+    buf.frontier[g] |= (uint64_t)1 << k;
+    buf.visited[g] |= (uint64_t)1 << k;
+    row_ptrs[k][g] = 0;
+  }
+
+  for (int d = 1; !frontier_nodes.empty(); ++d) {
+    // expand all searches at once, word by word
+    auto& next_nodes = buf.next_nodes;
+    next_nodes.clear();
+    for (auto n : frontier_nodes) {
+      const uint64_t bits = buf.frontier[n];
+      buf.frontier[n] = 0;
+      for (auto m : csr->getNeighbors(n)) {
+        if ((bits & ~buf.visited[m]) == 0) continue;
+        if (buf.next[m] == 0) next_nodes.push_back(m);
+        buf.next[m] |= bits;
+      }
+    }
+
+    // nodes reached first by some searches
+    frontier_nodes.clear();
+    for (auto m : next_nodes) {
+      const uint64_t bits = buf.next[m] & ~buf.visited[m];
+      buf.next[m] = 0;
+      buf.visited[m] |= bits;
+      buf.frontier[m] = bits;
+      frontier_nodes.push_back(m);
+      for (uint64_t b = bits; b != 0; b &= b - 1) {
+        row_ptrs[__builtin_ctzll(b)][m] = d;
+      }
+    }
+  }
+}
@@ -215,14 +215,15 @@ void MAPF_DP_Execution::simulate()
 {
   info("  ub_delay_prob=" + std::to_string(ub_delay_prob));
 
-  // occupied nodes
-  std::vector<int> occupancy(P->getG()->getNodesSize(), MAPF_DP_Agent::NIL);
+  // occupied nodes, on indices of the CSR graph
+  const CSRGraph* csr = P->getCSR();
+  std::vector<int> occupancy(csr->getNodesSize(), MAPF_DP_Agent::NIL);
 
   // setup agents
   MAPF_DP_Agents A;
   for (int i = 0; i < P->getNum(); ++i) {
-    A.push_back(std::make_shared<MAPF_DP_Agent>(i, plan[i]));
-    occupancy[A[i]->tail->id] = i;
+    A.push_back(std::make_shared<MAPF_DP_Agent>(i, plan[i], csr));
+    occupancy[A[i]->getTailIndex()] = i;
   }
 
   // setup utilities
@@ -231,9 +232,9 @@ void MAPF_DP_Execution::simulate()
       [&](MAPF_DP_Agent_p a, MAPF_DP_Agents& agents) {
         if (a->mode == MAPF_DP_Agent::EXTENDED || a->isFinished()) return true;
         // next location
-        auto v_next = a->getNextNode();
+        auto v_next = a->getNextIndex();
         // agent who uses v_next
-        auto a_j = occupancy[v_next->id];
+        auto a_j = occupancy[v_next];
         // no one uses v_next
         if (a_j == MAPF_DP_Agent::NIL) return false;
         // check deadlock
@@ -344,14 +345,15 @@ PrimitiveExecution::PrimitiveExecution(Problem* _P, std::string _plan_file,
 
 void PrimitiveExecution::simulate()
 {
-  // occupied nodes
-  std::vector<int> occupancy(P->getG()->getNodesSize(), Agent::NIL);
+  // occupied nodes, on indices of the CSR graph
+  const CSRGraph* csr = P->getCSR();
+  std::vector<int> occupancy(csr->getNodesSize(), Agent::NIL);
 
   // setup agents
   PrimitiveAgents A;
   for (int i = 0; i < P->getNum(); ++i) {
-    A.push_back(std::make_shared<PrimitiveAgent>(i, plan[i]));
-    occupancy[A[i]->tail->id] = i;
+    A.push_back(std::make_shared<PrimitiveAgent>(i, plan[i], csr));
+    occupancy[A[i]->getTailIndex()] = i;
   }
 
   // setup utilities
@@ -360,9 +362,9 @@ void PrimitiveExecution::simulate()
         // i.e., agents cannot move
         if (a->isFinished()) return false;
         // next location
-        auto v_next = a->getNextNode();
+        auto v_next = a->getNextIndex();
         // agent who uses v_next
-        auto a_j = occupancy[v_next->id];
+        auto a_j = occupancy[v_next];
         // no one uses v_next
         if (a_j == Agent::NIL) return true;
         // check deadlock
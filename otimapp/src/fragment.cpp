@@ -1,95 +1,389 @@
 #include "../include/fragment.hpp"
 
+#include <atomic>
+#include <cstring>
 #include <iostream>
-#include <set>
+#include <tuple>
+#include <type_traits>
 
 #include "../include/util.hpp"
 
-TableFragment::TableFragment(Graph* _G, const int _max_fragment_size)
+TableFragment::TableFragment(Graph* _G, const int _max_fragment_size,
+                             const CSRGraph* _csr)
     : t_from(_G->getNodesSize()),
       t_to(_G->getNodesSize()),
       G(_G),
-      max_fragment_size(_max_fragment_size)
+      csr(_csr),
+      max_fragment_size(_max_fragment_size),
+      fragments_num(0),
+      agent_entries_num(0),
+      fragments_limit(-1),
+      memory_budget(0),
+      use_index(true),
+      use_signatures(true),
+      journaling(false),
+      use_topology_memo(true),
+      t_pending_out(_G->getNodesSize()),
+      t_pending_in(_G->getNodesSize()),
+      ready_head(0),
+      moves_done_num(0)
 {
+  if (csr == nullptr) {
+    csr_owned = std::make_unique<CSRGraph>(G);
+    csr = csr_owned.get();
+  }
 }
 
 TableFragment::~TableFragment()
 {
-  for (auto cycles : t_from) {
-    for (auto c : cycles) delete c;
+  // fragments are trivially destructible, the arena releases all at once
+  static_assert(std::is_trivially_destructible<Fragment>::value);
+}
+
+// splitmix64
+static uint64_t mixHash(uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+FragmentHashSet::FragmentHashSet() : slots(16, nullptr), size(0) {}
+
+void FragmentHashSet::rehash(const std::size_t capacity)
+{
+  std::vector<Fragment*> old_slots(capacity, nullptr);
+  std::swap(slots, old_slots);
+  const std::size_t mask = slots.size() - 1;
+  for (auto c : old_slots) {
+    if (c == nullptr) continue;
+    auto i = c->key & mask;
+    while (slots[i] != nullptr) i = (i + 1) & mask;
+    slots[i] = c;
   }
 }
 
-bool TableFragment::existDuplication(const std::deque<Node*>& path,
-                                     const std::deque<int>& agents)
+void FragmentHashSet::insert(Fragment* c)
 {
-  std::set<int> set_agents;
-  for (auto itr = agents.begin(); itr != agents.end(); ++itr)
-    set_agents.insert(*itr);
-  for (auto c : t_from[path.front()->id]) {
-    // different paths
-    if (c->path != path) continue;
+  // keep load factor below 0.5
+  if ((size + 1) * 2 > slots.size()) rehash(slots.size() * 2);
+  const std::size_t mask = slots.size() - 1;
+  auto i = c->key & mask;
+  while (slots[i] != nullptr) i = (i + 1) & mask;
+  slots[i] = c;
+  ++size;
+}
+
+void FragmentHashSet::erase(Fragment* c)
+{
+  const std::size_t mask = slots.size() - 1;
+  auto i = c->key & mask;
+  while (slots[i] != c) i = (i + 1) & mask;
+  slots[i] = nullptr;
+  --size;
 
-    // different agents
-    std::set<int> c_agents;
-    for (auto itr = c->agents.begin(); itr != c->agents.end(); ++itr)
-      c_agents.insert(*itr);
-    if (c_agents != set_agents) continue;
+  // backward shift deletion
+  for (auto j = (i + 1) & mask; slots[j] != nullptr; j = (j + 1) & mask) {
+    auto k = slots[j]->key & mask;
+    // the ideal position k is cyclically in (i, j] -> keep
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+    slots[i] = slots[j];
+    slots[j] = nullptr;
+    i = j;
+  }
+}
 
-    // duplication exists
+// remove an element keeping the order, return its position
+static int eraseElement(std::vector<Fragment*>& arr, Fragment* c)
+{
+  // recently added fragments are likely to be removed
+  for (int i = (int)arr.size() - 1; i >= 0; --i) {
+    if (arr[i] == c) {
+      arr.erase(arr.begin() + i);
+      return i;
+    }
+  }
+  return -1;
+}
+
+uint64_t TableFragment::getKey(const std::vector<int>& path,
+                               const std::vector<int>& agents)
+{
+  // sequence of nodes
+  uint64_t key = path.size();
+  for (auto v : path) key = mixHash(key ^ (uint64_t)v);
+  // set of agents, commutative
+  uint64_t key_agents = 0;
+  for (auto i : agents) key_agents += mixHash((uint64_t)i + 0x51ed27);
+  return mixHash(key ^ key_agents);
+}
+
+bool TableFragment::existDuplication(const std::vector<int>& path,
+                                     const std::vector<int>& agents,
+                                     const uint64_t key)
+{
+  auto isSame = [&](Fragment* c) {
+    // different paths
+    if (c->path.size() != (int)path.size() ||
+        !std::equal(path.begin(), path.end(), c->path.begin()))
+      return false;
+
+    // different agents, agents in one fragment are distinct
+    if (c->agents.size() != (int)agents.size()) return false;
+    for (auto i : agents) {
+      if (!inArray(i, c->agents)) return false;
+    }
     return true;
+  };
+
+  if (use_index) return index.find(key, isSame) != nullptr;
+
+  // linear scan
+  for (auto c : t_from[path.front()]) {
+    if (isSame(c)) return true;
   }
   return false;
 }
 
-bool TableFragment::isValidTopologyCondition(
-    const std::deque<Node*>& path) const
+bool TableFragment::isValidTopologyCondition(const std::vector<int>& path)
 {
   if (max_fragment_size == -1) return true;
-
-  auto head = path.front();
-  auto tail = path.back();
   auto length = (int)path.size() - 1;  // number of agents in the fragment
+  if (!use_topology_memo) {
+    return existClosingPath(path, max_fragment_size - length, bfs);
+  }
 
   // fast check
-  if (head->manhattanDist(tail) + length > max_fragment_size) return false;
+  computeBall(path.front());
+  if (!isValidLowerBound(path)) return false;
+
+  // use cache, the multiset of prohibited nodes determines length
+  memo_key.assign(path.begin() + 1, path.end() - 1);
+  std::sort(memo_key.begin(), memo_key.end());
+  memo_key.push_back(path.front());
+  memo_key.push_back(path.back());
+  uint64_t hash = 0;
+  for (auto v : memo_key) hash = mixHash(hash ^ (uint64_t)v);
+  auto range = memo_table.equal_range(hash);
+  for (auto itr = range.first; itr != range.second; ++itr) {
+    if (itr->second->key != memo_key) continue;
+    memo_list.splice(memo_list.begin(), memo_list, itr->second);
+    return itr->second->valid;
+  }
 
   // finding shortest path
-  Nodes prohibited;
-  for (int t = 1; t < (int)path.size() - 1; ++t) prohibited.push_back(path[t]);
-  auto p = G->getPath(tail, head, prohibited);
-  if (p.empty()) return false;
-  if ((int)p.size() - 1 + length > max_fragment_size) return false;
+  auto res = existClosingPath(path, max_fragment_size - length, bfs);
 
-  return true;
+  // register result
+  memo_list.push_front({memo_key, hash, res});
+  memo_table.emplace(hash, memo_list.begin());
+  if (memo_list.size() > MEMO_CAPACITY) {
+    auto last = std::prev(memo_list.end());
+    auto range_last = memo_table.equal_range(last->hash);
+    for (auto itr = range_last.first; itr != range_last.second; ++itr) {
+      if (itr->second != last) continue;
+      memo_table.erase(itr);
+      break;
+    }
+    memo_list.pop_back();
+  }
+
+  return res;
 }
 
-Fragment* TableFragment::createNewFragment(const std::deque<Node*>& path,
-                                           const std::deque<int>& agents)
+void TableFragment::computeBall(const int head)
 {
-  auto c = new Fragment();
-  c->agents = agents;
-  c->path = path;
+  if (t_ball.empty()) {
+    t_ball.resize(G->getNodesSize());
+    t_ball_computed.resize(G->getNodesSize(), false);
+  }
+  if (t_ball_computed[head]) return;
+  t_ball_computed[head] = true;
+
+  // breadth first search on indices of csr, graphs are undirected
+  auto& ball = t_ball[head];
+  std::queue<int> OPEN;
+  std::unordered_map<int, int> CLOSE;
+  OPEN.push(csr->getIndex(head));
+  CLOSE[csr->getIndex(head)] = 0;
+  while (!OPEN.empty()) {
+    auto n = OPEN.front();
+    OPEN.pop();
+    const int d_n = CLOSE[n];
+    if (d_n >= max_fragment_size) continue;
+    for (auto m : csr->getNeighbors(n)) {
+      if (CLOSE.find(m) != CLOSE.end()) continue;
+      CLOSE[m] = d_n + 1;
+      OPEN.push(m);
+    }
+  }
+  for (auto& e : CLOSE) ball.emplace_back(csr->getNode(e.first)->id, e.second);
+  std::sort(ball.begin(), ball.end());
+}
+
+bool TableFragment::isValidLowerBound(const std::vector<int>& path) const
+{
+  auto head = G->getNode(path.front());
+  auto tail = G->getNode(path.back());
+  auto length = (int)path.size() - 1;  // number of agents in the fragment
+
+  // manhattan distance
+  if (head->manhattanDist(tail) + length > max_fragment_size) return false;
+
+  // prohibited nodes only make the path longer
+  auto& ball = t_ball[head->id];
+  auto itr = std::lower_bound(ball.begin(), ball.end(),
+                              std::make_pair(tail->id, -1));
+  if (itr == ball.end() || itr->first != tail->id) return false;
+  return itr->second + length <= max_fragment_size;
+}
+
+bool TableFragment::existClosingPath(const std::vector<int>& path,
+                                     const int max_dist,
+                                     SearchBuffer& buf) const
+{
+  if (buf.stamp.empty()) {
+    buf.stamp.resize(csr->getNodesSize(), 0);
+    buf.dist.resize(csr->getNodesSize(), 0);
+    buf.cnt = 0;
+  }
+  ++buf.cnt;
+  auto& OPEN = buf.OPEN;
+  while (!OPEN.empty()) OPEN.pop();
+
+  // prohibit interior nodes, on indices of csr
+  for (int t = 1; t < (int)path.size() - 1; ++t) {
+    buf.stamp[csr->getIndex(path[t])] = buf.cnt;
+  }
+
+  // from tail to head
+  const int head = csr->getIndex(path.front());
+  const int tail = csr->getIndex(path.back());
+  OPEN.push(tail);
+  buf.stamp[tail] = buf.cnt;
+  buf.dist[tail] = 0;
+  while (!OPEN.empty()) {
+    auto n = OPEN.front();
+    OPEN.pop();
+    if (n == head) return true;
+    const int d_n = buf.dist[n];
+    if (d_n >= max_dist) continue;
+    for (auto m : csr->getNeighbors(n)) {
+      if (buf.stamp[m] == buf.cnt) continue;
+      buf.stamp[m] = buf.cnt;
+      buf.dist[m] = d_n + 1;
+      OPEN.push(m);
+    }
+  }
+  return false;
+}
+
+Fragment* TableFragment::createNewFragment(const std::vector<int>& path,
+                                           const std::vector<int>& agents,
+                                           const uint64_t key)
+{
+  // copy contents to the arena
+  auto path_data = arena.allocateArray<int>(path.size());
+  std::memcpy(path_data, path.data(), sizeof(int) * path.size());
+  auto agents_data = arena.allocateArray<int>(agents.size());
+  std::memcpy(agents_data, agents.data(), sizeof(int) * agents.size());
+
+  auto c = arena.create<Fragment>();
+  c->path = FlatArray<int>(path_data, path.size());
+  c->agents = FlatArray<int>(agents_data, agents.size());
+  c->key = key;
+  c->mask_path = use_signatures ? getSignature(path) : ~(uint64_t)0;
+  c->mask_agents = use_signatures ? getSignature(agents) : ~(uint64_t)0;
 
   // register on tables
-  t_from[c->path.front()->id].push_back(c);
-  t_to[c->path.back()->id].push_back(c);
+  t_from[c->path.front()].push_back(c);
+  t_to[c->path.back()].push_back(c);
+  if (c->path.front() == c->path.back()) t_cycle.push_back(c);
+  for (auto i : c->agents) {
+    if (i >= (int)t_agent.size()) t_agent.resize(i + 1);
+    t_agent[i].push_back(c);
+  }
+  index.insert(c);
+  if (journaling) journal.push_back({true, c, 0});
+
+  // statistics
+  countFragment(c, 1);
+  ++stats.created;
+  if (stats.length_hist.size() <= agents.size()) {
+    stats.length_hist.resize(agents.size() + 1, 0);
+  }
+  ++stats.length_hist[agents.size()];
+  stats.max_bucket_from =
+      std::max(stats.max_bucket_from, t_from[c->path.front()].size());
+  stats.max_bucket_to =
+      std::max(stats.max_bucket_to, t_to[c->path.back()].size());
+  const auto bytes = getMemoryBytes();
+  stats.peak_fragments =
+      std::max(stats.peak_fragments, (std::size_t)fragments_num);
+  stats.peak_bytes = std::max(stats.peak_bytes, bytes);
+
+  // limits
+  if ((fragments_limit >= 0 && fragments_num >= fragments_limit) ||
+      (memory_budget > 0 && bytes >= memory_budget)) {
+    stats.over_limit = true;
+  }
 
   return c;
 }
 
+void TableFragment::countFragment(const Fragment* c, const int sign)
+{
+  fragments_num += sign;
+  agent_entries_num += sign * c->agents.size();
+}
+
+std::size_t TableFragment::getMemoryBytes() const
+{
+  // fragments, t_from and t_to, t_agent, index, journal for rollback
+  return arena.getReservedBytes() +
+         sizeof(Fragment*) * (2 * fragments_num + agent_entries_num +
+                              index.getCapacity()) +
+         sizeof(Change) * journal.capacity() +
+         sizeof(int) * journal_positions.capacity();
+}
+
+void FragmentStats::merge(const FragmentStats& other)
+{
+  created += other.created;
+  duplicates += other.duplicates;
+  topology += other.topology;
+  peak_fragments = std::max(peak_fragments, other.peak_fragments);
+  peak_bytes = std::max(peak_bytes, other.peak_bytes);
+  max_bucket_from = std::max(max_bucket_from, other.max_bucket_from);
+  max_bucket_to = std::max(max_bucket_to, other.max_bucket_to);
+  if (length_hist.size() < other.length_hist.size()) {
+    length_hist.resize(other.length_hist.size(), 0);
+  }
+  for (std::size_t k = 0; k < other.length_hist.size(); ++k) {
+    length_hist[k] += other.length_hist[k];
+  }
+  over_limit |= other.over_limit;
+}
+
 Fragment* TableFragment::getPotentialDeadlockIfExist(
-    const std::deque<Node*>& path, const std::deque<int>& agents)
+    const std::vector<int>& path, const std::vector<int>& agents)
 {
   // check topology constraints
-  if (path.front() != path.back() && !isValidTopologyCondition(path))
+  if (path.front() != path.back() && !isValidTopologyCondition(path)) {
+    ++stats.topology;
     return nullptr;
+  }
 
   // check duplication
-  if (existDuplication(path, agents)) return nullptr;
+  auto key = getKey(path, agents);
+  if (existDuplication(path, agents, key)) {
+    ++stats.duplicates;
+    return nullptr;
+  }
 
   // create new fragment
-  auto c = createNewFragment(path, agents);
+  auto c = createNewFragment(path, agents, key);
 
   return (c->path.front() == c->path.back()) ? c : nullptr;
 }
@@ -100,7 +394,7 @@ Fragment* TableFragment::getPotentialDeadlockIfExist(const int id, Node* head,
                                                      Node* tail)
 {
   // avoid loop with own path
-  if (c_base != nullptr && inArray(id, c_base->agents)) return nullptr;
+  if (c_base != nullptr && c_base->hasAgent(id)) return nullptr;
 
   // check maximum fragment length
   if (c_base != nullptr && max_fragment_size != -1) {
@@ -113,130 +407,624 @@ Fragment* TableFragment::getPotentialDeadlockIfExist(const int id, Node* head,
   }
 
   // setup agents
-  std::deque<int> agents;
+  buf_agents.clear();
   if (c_base == nullptr) {
-    agents.push_front(id);
+    buf_agents.push_back(id);
   } else {
-    agents = c_base->agents;
-    if (c_base->path.front() != head) agents.push_front(id);
-    if (c_base->path.back() != tail) agents.push_back(id);
+    if (c_base->path.front() != head->id) buf_agents.push_back(id);
+    buf_agents.insert(buf_agents.end(), c_base->agents.begin(),
+                      c_base->agents.end());
+    if (c_base->path.back() != tail->id) buf_agents.push_back(id);
   }
 
   // setup path
-  std::deque<Node*> path;
-  if (c_base == nullptr || head != c_base->path.front()) path.push_back(head);
+  buf_path.clear();
+  if (c_base == nullptr || head->id != c_base->path.front())
+    buf_path.push_back(head->id);
   if (c_base != nullptr)
-    for (auto itr = c_base->path.begin(); itr != c_base->path.end(); ++itr)
-      path.push_back(*itr);
-  if (c_base == nullptr || tail != c_base->path.back()) path.push_back(tail);
+    buf_path.insert(buf_path.end(), c_base->path.begin(), c_base->path.end());
+  if (c_base == nullptr || tail->id != c_base->path.back())
+    buf_path.push_back(tail->id);
 
-  return getPotentialDeadlockIfExist(path, agents);
+  return getPotentialDeadlockIfExist(buf_path, buf_agents);
 }
 
 // return deadlock or nullptr
-Fragment* TableFragment::registerNewPath(const int id, const Path path,
-                                         const bool force, const int time_limit)
+Fragment* TableFragment::registerNewPath(const int id, const Path& path,
+                                         const bool force, Deadline* deadline)
 {
+  if (detector != nullptr) {
+    return registerNewPathWithDetector(id, path, force, deadline);
+  }
+  if (moves != nullptr) {
+    return registerNewPathWithPruning(id, path, force, deadline);
+  }
+
   Fragment* res = nullptr;
-  auto t_s = Time::now();
 
   // update cycles step by step
   for (int t = 1; t < (int)path.size(); ++t) {
     // check time limit
-    if (time_limit >= 0 && getElapsedTime(t_s) > time_limit) return nullptr;
+    if (isInterrupted(deadline)) return nullptr;
+
+    res = registerNewMove(id, path[t - 1], path[t], force, deadline);
+    if (!force && res != nullptr) return res;
+  }
+
+  return res;
+}
+
+Fragment* TableFragment::registerNewMove(const int id, Node* v_before,
+                                         Node* v_next, const bool force,
+                                         Deadline* deadline)
+{
+  // add own segment
+  auto res = getPotentialDeadlockIfExist(id, v_before, nullptr, v_next);
+  if (!force && res != nullptr) return res;
 
-    auto v_before = path[t - 1];
-    auto v_next = path[t];
+  // check existing fragments on table_to
+  for (auto c : t_to[v_before->id]) {
+    res = getPotentialDeadlockIfExist(id, G->getNode(c->path.front()), c,
+                                      v_next);
+    if (!force && res != nullptr) return res;
+  }
 
-    // add own segment
-    res = getPotentialDeadlockIfExist(id, v_before, nullptr, v_next);
+  // check existing fragments on table_from
+  for (auto c : t_from[v_next->id]) {
+    res = getPotentialDeadlockIfExist(id, v_before, c,
+                                      G->getNode(c->path.back()));
     if (!force && res != nullptr) return res;
+  }
+
+  // connect two fragments
+  std::vector<Fragment*> c_tails, c_heads;
+  // 1. extract candidates
+  for (auto c_tail : t_to[v_before->id])
+    if (!c_tail->hasAgent(id)) c_tails.push_back(c_tail);
+  for (auto c_head : t_from[v_next->id])
+    if (!c_head->hasAgent(id)) c_heads.push_back(c_head);
+
+  // 2. main loop
+  Fragment* c = nullptr;
+  if (pool != nullptr &&
+      c_tails.size() * c_heads.size() >= (std::size_t)PARALLEL_MIN_PAIRS) {
+    c = joinFragmentsParallel(id, c_tails, c_heads, force, deadline);
+  } else {
+    c = joinFragments(id, c_tails, c_heads, force, deadline);
+  }
+  if (!force && c != nullptr) return c;
+
+  return res;
+}
+
+Fragment* TableFragment::registerNewPathWithPruning(const int id,
+                                                    const Path& path,
+                                                    const bool force,
+                                                    Deadline* deadline)
+{
+  // moves left by the last call, e.g., returned by finding a deadlock
+  auto res = registerReadyMoves(force, deadline);
+  if (!force && res != nullptr) return res;
+  compactMoves();
+
+  if (id >= (int)t_agent_move.size()) t_agent_move.resize(id + 1);
+  for (int t = 1; t < (int)path.size(); ++t) {
+    // check time limit
+    if (isInterrupted(deadline)) return nullptr;
+
+    const int from = path[t - 1]->id;
+    const int to = path[t]->id;
+    buf_absorbed.clear();
+    moves->insertEdge(from, to, id, &buf_absorbed);
+
+    // pending moves become inside a component by merging components,
+    // at least one of their endpoints was in absorbed components
+    const auto ready_size = ready.size();
+    for (auto v : buf_absorbed) {
+      for (auto arr : {&t_pending_out[v], &t_pending_in[v]}) {
+        for (auto k : *arr) {
+          auto& m = t_move[k];
+          if (m.state != Move::PENDING || !moves->isSameComp(m.from, m.to)) {
+            continue;
+          }
+          m.state = Move::READY;
+          ready.push_back(k);
+        }
+        arr->erase(std::remove_if(arr->begin(), arr->end(),
+                                  [&](int k) {
+                                    return t_move[k].state != Move::PENDING;
+                                  }),
+                   arr->end());
+      }
+    }
+    // keep the order of arrival
+    std::sort(ready.begin() + ready_size, ready.end());
+
+    // new move
+    const int k = t_move.size();
+    t_move.push_back({from, to, id, Move::PENDING});
+    t_agent_move[id].push_back(k);
+    if (from == to || moves->isSameComp(from, to)) {
+      t_move[k].state = Move::READY;
+      ready.push_back(k);
+    } else {
+      t_pending_out[from].push_back(k);
+      t_pending_in[to].push_back(k);
+    }
+
+    res = registerReadyMoves(force, deadline);
+    if (!force && res != nullptr) return res;
+  }
+
+  return res;
+}
+
+Fragment* TableFragment::registerReadyMoves(const bool force,
+                                            Deadline* deadline)
+{
+  Fragment* res = nullptr;
+  while (ready_head < ready.size()) {
+    // check time limit
+    if (isInterrupted(deadline)) return nullptr;
+
+    auto& m = t_move[ready[ready_head++]];
+    if (m.state != Move::READY) continue;
+    m.state = Move::DONE;
+    ++moves_done_num;
+    res = registerNewMove(m.agent, G->getNode(m.from), G->getNode(m.to), force,
+                          deadline);
+    if (!force && res != nullptr) return res;
+  }
+  ready.clear();
+  ready_head = 0;
+  return res;
+}
+
+void TableFragment::compactMoves()
+{
+  if (moves_done_num < COMPACT_MIN_MOVES ||
+      moves_done_num * 2 < (int)t_move.size()) {
+    return;
+  }
 
-    // check existing fragments on table_to
-    for (auto c : t_to[v_before->id]) {
-      res = getPotentialDeadlockIfExist(id, c->path.front(), c, v_next);
+  std::vector<int> new_id(t_move.size(), -1);
+  std::vector<Move> arr;
+  for (int k = 0; k < (int)t_move.size(); ++k) {
+    if (t_move[k].state == Move::DONE) continue;
+    new_id[k] = arr.size();
+    arr.push_back(t_move[k]);
+  }
+  t_move.swap(arr);
+  moves_done_num = 0;
+
+  auto update = [&](std::vector<int>& ids) {
+    std::vector<int> tmp;
+    for (auto k : ids) {
+      if (new_id[k] != -1) tmp.push_back(new_id[k]);
+    }
+    ids.swap(tmp);
+  };
+  for (auto& ids : t_pending_out) update(ids);
+  for (auto& ids : t_pending_in) update(ids);
+  for (auto& ids : t_agent_move) update(ids);
+  ready.erase(ready.begin(), ready.begin() + ready_head);
+  ready_head = 0;
+  update(ready);
+}
+
+// check length and self loop
+static bool isConnectable(const Fragment* c_tail, const Fragment* c_head,
+                          const int max_fragment_size)
+{
+  // check length
+  if (max_fragment_size != -1) {
+    int size = (int)(c_tail->agents.size() + c_head->agents.size()) + 1;
+    if (size > max_fragment_size) {
+      return false;
+    } else if (size == max_fragment_size &&
+               c_tail->path.front() != c_head->path.back()) {
+      return false;
+    }
+  }
+
+  // avoid self loop, exact check only when signatures intersect
+  // agents
+  if (c_tail->mask_agents & c_head->mask_agents) {
+    for (auto i : c_tail->agents) {
+      if (c_head->hasAgent(i)) return false;
+    }
+  }
+  // path
+  if (c_tail->mask_path & c_head->mask_path) {
+    for (auto v : c_tail->path) {
+      if ((c_head->mask_path & getSignatureBit(v)) &&
+          inArray(v, c_head->path)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// create body, c_tail -> id -> c_head
+static void setupConnectedFragment(const int id, const Fragment* c_tail,
+                                   const Fragment* c_head,
+                                   std::vector<int>& path,
+                                   std::vector<int>& agents)
+{
+  // agents
+  agents.clear();
+  agents.insert(agents.end(), c_tail->agents.begin(), c_tail->agents.end());
+  agents.push_back(id);
+  agents.insert(agents.end(), c_head->agents.begin(), c_head->agents.end());
+  // path
+  path.clear();
+  path.insert(path.end(), c_tail->path.begin(), c_tail->path.end());
+  path.insert(path.end(), c_head->path.begin(), c_head->path.end());
+}
+
+Fragment* TableFragment::joinFragments(const int id,
+                                       const std::vector<Fragment*>& c_tails,
+                                       const std::vector<Fragment*>& c_heads,
+                                       const bool force, Deadline* deadline)
+{
+  Fragment* res = nullptr;
+  for (auto c_tail : c_tails) {
+    for (auto c_head : c_heads) {
+      // check time limit
+      if (isInterrupted(deadline)) return nullptr;
+
+      if (!isConnectable(c_tail, c_head, max_fragment_size)) continue;
+      setupConnectedFragment(id, c_tail, c_head, buf_path, buf_agents);
+
+      // register
+      res = getPotentialDeadlockIfExist(buf_path, buf_agents);
       if (!force && res != nullptr) return res;
     }
+  }
+  return res;
+}
+
+Fragment* TableFragment::joinFragmentsParallel(
+    const int id, const std::vector<Fragment*>& c_tails,
+    const std::vector<Fragment*>& c_heads, const bool force,
+    Deadline* deadline)
+{
+  // balls are lazily computed, prepare them before starting threads
+  if (max_fragment_size != -1 && use_topology_memo) {
+    for (auto c_tail : c_tails) computeBall(c_tail->path.front());
+  }
+
+  // pairs are numbered as (tail, head), each thread takes a contiguous range
+  const std::size_t heads_num = c_heads.size();
+  const std::size_t pairs_num = c_tails.size() * heads_num;
+  const std::size_t threads_num = stagings.size();
+  // smallest pair creating a deadlock, later pairs are no longer necessary
+  std::atomic<std::size_t> cycle_bound(pairs_num);
+
+  pool->run([&](const int k) {
+    auto& st = stagings[k];
+    st.entries.clear();
+    st.duplicates = 0;
+    st.topology = 0;
+    st.data.clear();
+    int cnt = 0;  // for deadline
+    const std::size_t p_from = pairs_num * k / threads_num;
+    const std::size_t p_to = pairs_num * (k + 1) / threads_num;
+    for (auto p = p_from; p < p_to; ++p) {
+      if (deadline != nullptr && deadline->expired(cnt)) break;
+      if ((p % heads_num == 0 || p == p_from) &&
+          p > cycle_bound.load(std::memory_order_relaxed)) {
+        break;
+      }
+      auto c_tail = c_tails[p / heads_num];
+      auto c_head = c_heads[p % heads_num];
+      if (!isConnectable(c_tail, c_head, max_fragment_size)) continue;
+      setupConnectedFragment(id, c_tail, c_head, st.path, st.agents);
+
+      // check topology without cache, and duplication with the table as is
+      const bool is_cycle = st.path.front() == st.path.back();
+      if (!is_cycle && max_fragment_size != -1 &&
+          ((use_topology_memo && !isValidLowerBound(st.path)) ||
+           !existClosingPath(st.path,
+                             max_fragment_size - (int)st.path.size() + 1,
+                             st.bfs))) {
+        ++st.topology;
+        continue;
+      }
+      auto key = getKey(st.path, st.agents);
+      if (existDuplication(st.path, st.agents, key)) {
+        ++st.duplicates;
+        continue;
+      }
+
+      // stage
+      st.entries.push_back(
+          {st.data.size(), (int)st.path.size(), (int)st.agents.size(), key});
+      st.data.insert(st.data.end(), st.path.begin(), st.path.end());
+      st.data.insert(st.data.end(), st.agents.begin(), st.agents.end());
+
+      // the first deadlock is enough
+      if (is_cycle && !force) {
+        auto q = cycle_bound.load();
+        while (p < q && !cycle_bound.compare_exchange_weak(q, p)) continue;
+        break;
+      }
+    }
+  });
+  for (auto& st : stagings) {
+    stats.duplicates += st.duplicates;
+    stats.topology += st.topology;
+  }
+  if (deadline != nullptr && deadline->expiredNow()) return nullptr;
 
-    // check existing fragments on table_from
-    for (auto c : t_from[v_next->id]) {
-      res = getPotentialDeadlockIfExist(id, v_before, c, c->path.back());
+  // merge in order of pairs, same as sequential version
+  Fragment* res = nullptr;
+  for (auto& st : stagings) {
+    for (auto& e : st.entries) {
+      auto itr = st.data.begin() + e.offset;
+      buf_path.assign(itr, itr + e.path_len);
+      buf_agents.assign(itr + e.path_len, itr + e.path_len + e.agents_len);
+      if (stats.over_limit) return nullptr;
+      // candidates of different threads may be identical
+      if (existDuplication(buf_path, buf_agents, e.key)) {
+        ++stats.duplicates;
+        continue;
+      }
+      auto c = createNewFragment(buf_path, buf_agents, e.key);
+      res = (c->path.front() == c->path.back()) ? c : nullptr;
       if (!force && res != nullptr) return res;
     }
+  }
+  return res;
+}
 
-    // connect two fragments
-    std::vector<Fragment*> c_tails, c_heads;
-    // 1. extract candidates
-    for (auto c_tail : t_to[v_before->id])
-      if (!inArray(id, c_tail->agents)) c_tails.push_back(c_tail);
-    for (auto c_head : t_from[v_next->id])
-      if (!inArray(id, c_head->agents)) c_heads.push_back(c_head);
+Fragment* TableFragment::registerNewPathWithDetector(const int id,
+                                                     const Path& path,
+                                                     const bool force,
+                                                     Deadline* deadline)
+{
+  Fragment* res = nullptr;
+  for (int t = 1; t < (int)path.size(); ++t) {
+    // check time limit
+    if (isInterrupted(deadline)) return nullptr;
 
-    // 2. main loop
-    for (auto c_tail : c_tails) {
-      // check time limit
-      if (time_limit >= 0 && getElapsedTime(t_s) > time_limit) return nullptr;
+    if (detector->addEdge(path[t - 1]->id, path[t]->id, id, buf_path,
+                          buf_agents)) {
+      auto c = registerWitness();
+      if (!force) return c;
+      if (res == nullptr) res = c;
+    }
+  }
+  return res;
+}
 
-      for (auto c_head : c_heads) {
-        // check length
-        if (max_fragment_size != -1) {
-          int size = (int)(c_tail->agents.size() + c_head->agents.size()) + 1;
-          if (size > max_fragment_size) {
-            continue;
-          } else if (size == max_fragment_size &&
-                     c_tail->path.front() != c_head->path.back()) {
-            continue;
-          }
-        }
+Fragment* TableFragment::registerWitness()
+{
+  auto key = getKey(buf_path, buf_agents);
+  // found again after removing paths, return one of deadlocks
+  if (existDuplication(buf_path, buf_agents, key)) {
+    ++stats.duplicates;
+    return t_cycle.front();
+  }
+  return createNewFragment(buf_path, buf_agents, key);
+}
 
-        // avoid self loop
-        {
-          // agents
-          bool self_loop = false;
-          for (auto i : c_tail->agents) {
-            if (inArray(i, c_head->agents)) {
-              self_loop = true;
-            }
-          }
-          if (self_loop) continue;
+bool TableFragment::existPotentialDeadlock(const int id, Node* parent,
+                                           Node* child)
+{
+  if (detector != nullptr) {
+    return detector->findCycle(parent->id, child->id, id, buf_path,
+                               buf_agents);
+  }
 
-          // path
-          for (auto i : c_tail->path) {
-            if (inArray(i, c_head->path)) {
-              self_loop = true;
-            }
-          }
-          if (self_loop) continue;
-        }
+  // fragments across components are pending, and ready moves are left by
+  // an interrupted registration, the table is not modified during queries
+  if (moves != nullptr && (ready_head < ready.size() ||
+                           !moves->isSameComp(parent->id, child->id))) {
+    return moves->findCycle(parent->id, child->id, id, buf_path, buf_agents);
+  }
 
-        // create body
-        std::deque<int> agents;
-        std::deque<Node*> path;
-        {
-          // agents
-          for (auto i : c_tail->agents) agents.push_back(i);
-          agents.push_back(id);
-          for (auto i : c_head->agents) agents.push_back(i);
-          // path
-          for (auto v : c_tail->path) path.push_back(v);
-          for (auto v : c_head->path) path.push_back(v);
+  for (auto c : t_to[parent->id]) {
+    if (c->path.front() == child->id) return true;
+  }
+  return false;
+}
+
+void TableFragment::setCycleDetection(const bool flag)
+{
+  if (flag) {
+    detector = std::make_unique<CycleDetector>(G, max_fragment_size);
+    moves.reset();
+  } else {
+    detector.reset();
+  }
+}
+
+void TableFragment::setSccPruning(const bool flag)
+{
+  if (flag) {
+    if (moves == nullptr && detector == nullptr) {
+      moves = std::make_unique<CycleDetector>(G, max_fragment_size);
+    }
+    return;
+  }
+  if (moves == nullptr) return;
+
+  // complete all fragments
+  for (int k = 0; k < (int)t_move.size(); ++k) {
+    if (t_move[k].state != Move::PENDING) continue;
+    t_move[k].state = Move::READY;
+    ready.push_back(k);
+  }
+  registerReadyMoves(true, nullptr);
+  moves.reset();
+  t_move.clear();
+  for (auto& ids : t_pending_out) ids.clear();
+  for (auto& ids : t_pending_in) ids.clear();
+  t_agent_move.clear();
+  moves_done_num = 0;
+}
+
+void TableFragment::setThreadsNum(const int threads_num)
+{
+  if (threads_num <= 1) {
+    pool.reset();
+    stagings.clear();
+  } else {
+    pool = std::make_unique<ThreadPool>(threads_num);
+    stagings.resize(threads_num);
+  }
+}
+
+void TableFragment::removeFragment(Fragment* c)
+{
+  auto pos_offset = journal_positions.size();
+  auto pos_from = eraseElement(t_from[c->path.front()], c);
+  auto pos_to = eraseElement(t_to[c->path.back()], c);
+  if (journaling) {
+    journal_positions.push_back(pos_from);
+    journal_positions.push_back(pos_to);
+  }
+  if (c->path.front() == c->path.back()) {
+    auto pos = eraseElement(t_cycle, c);
+    if (journaling) journal_positions.push_back(pos);
+  }
+  for (auto i : c->agents) {
+    auto pos = eraseElement(t_agent[i], c);
+    if (journaling) journal_positions.push_back(pos);
+  }
+  index.erase(c);
+  countFragment(c, -1);
+  if (journaling) journal.push_back({false, c, pos_offset});
+}
+
+void TableFragment::unregisterPath(const int id)
+{
+  if (detector == nullptr) {
+    if (moves != nullptr) {
+      moves->removeAgent(id);
+      if (id < (int)t_agent_move.size()) {
+        for (auto k : t_agent_move[id]) {
+          if (t_move[k].state == Move::DONE) continue;
+          t_move[k].state = Move::DONE;
+          ++moves_done_num;
         }
+        t_agent_move[id].clear();
+      }
+    }
+    removeFragments(id);
+    return;
+  }
+
+  // each cycle is found by a move, other cycles may include the same move
+  std::vector<std::tuple<int, int, int>> witness_moves;  // from, to, agent
+  if (id < (int)t_agent.size()) {
+    for (auto c : t_agent[id]) {
+      if (c->agents.front() == id) continue;
+      witness_moves.emplace_back(c->path[0], c->path[1], c->agents.front());
+    }
+  }
+  detector->removeAgent(id);
+  removeFragments(id);
+  for (auto& [from, to, agent] : witness_moves) {
+    if (detector->findCycle(from, to, agent, buf_path, buf_agents)) {
+      registerWitness();
+    }
+  }
+}
+
+void TableFragment::removeFragments(const int id)
+{
+  if (id >= (int)t_agent.size()) return;
+
+  // removeFragment modifies t_agent[id]
+  auto fragments = t_agent[id];
 
-        // register
-        auto res = getPotentialDeadlockIfExist(path, agents);
-        if (!force && res != nullptr) return res;
+  // remove one by one to record positions
+  if (journaling) {
+    for (auto itr = fragments.rbegin(); itr != fragments.rend(); ++itr) {
+      removeFragment(*itr);
+    }
+    return;
+  }
+
+  // otherwise, compact each table once
+  std::vector<std::vector<Fragment*>*> tables = {&t_cycle};
+  for (auto c : fragments) {
+    c->removed = true;
+    index.erase(c);
+    countFragment(c, -1);
+    tables.push_back(&t_from[c->path.front()]);
+    tables.push_back(&t_to[c->path.back()]);
+    for (auto i : c->agents) tables.push_back(&t_agent[i]);
+  }
+  std::sort(tables.begin(), tables.end());
+  tables.erase(std::unique(tables.begin(), tables.end()), tables.end());
+  for (auto arr : tables) {
+    arr->erase(std::remove_if(arr->begin(), arr->end(),
+                              [](Fragment* c) { return c->removed; }),
+               arr->end());
+  }
+}
+
+TableFragment::Checkpoint TableFragment::getCheckpoint()
+{
+  setSccPruning(false);
+  journaling = true;
+  return {journal.size(), arena.getMark()};
+}
+
+void TableFragment::rollback(const Checkpoint& checkpoint)
+{
+  while (journal.size() > checkpoint.journal_size) {
+    auto change = journal.back();
+    journal.pop_back();
+    auto c = change.c;
+    if (change.added) {
+      eraseElement(t_from[c->path.front()], c);
+      eraseElement(t_to[c->path.back()], c);
+      if (c->path.front() == c->path.back()) eraseElement(t_cycle, c);
+      for (auto i : c->agents) eraseElement(t_agent[i], c);
+      index.erase(c);
+      countFragment(c, -1);
+    } else {
+      // restore the original positions
+      auto pos = journal_positions.begin() + change.pos_offset;
+      t_from[c->path.front()].insert(t_from[c->path.front()].begin() + pos[0],
+                                     c);
+      t_to[c->path.back()].insert(t_to[c->path.back()].begin() + pos[1], c);
+      pos += 2;
+      if (c->path.front() == c->path.back()) {
+        t_cycle.insert(t_cycle.begin() + *pos, c);
+        ++pos;
+      }
+      for (int k = 0; k < c->agents.size(); ++k) {
+        auto& arr = t_agent[c->agents[k]];
+        arr.insert(arr.begin() + pos[k], c);
       }
+      index.insert(c);
+      countFragment(c, 1);
+      journal_positions.resize(change.pos_offset);
     }
   }
 
-  return res;
+  // fragments created after the checkpoint are no longer referred
+  arena.rewind(checkpoint.mark);
+}
+
+void TableFragment::clearCheckpoints()
+{
+  journaling = false;
+  journal.clear();
+  journal_positions.clear();
 }
 
 void TableFragment::println()
 {
   for (auto cycles : t_from) {
     for (auto c : cycles) {
-      for (auto v : c->path) std::cout << v->id << " -> ";
+      for (auto v : c->path) std::cout << v << " -> ";
       std::cout << " : ";
       for (auto i : c->agents) std::cout << i << " -> ";
       std::cout << std::endl;
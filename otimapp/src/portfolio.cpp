@@ -0,0 +1,196 @@
+#include "../include/portfolio.hpp"
+
+#include <fstream>
+#include <sstream>
+
+#include "../include/dbs.hpp"
+#include "../include/pp.hpp"
+#include "../include/thread_pool.hpp"
+
+const std::string Portfolio::SOLVER_NAME = "PORTFOLIO";
+
+Portfolio::Portfolio(Problem* _P) : Solver(_P), winner(-1)
+{
+  solver_name = SOLVER_NAME;
+  // same random sequences as running each solver alone
+  members.push_back(std::make_unique<PP>(P));
+  members.push_back(std::make_unique<DBS>(P));
+  members_params.resize(members.size());
+}
+
+Portfolio::~Portfolio() {}
+
+void Portfolio::run()
+{
+  // members use the distance table of the portfolio and stop with it
+  race.reset(-1);
+  race.setParent(&deadline);
+  for (auto& member : members) {
+    member->setDistanceTable(distance_table);
+    member->setParentDeadline(&race);
+    member->setVerbose(isVerbose());
+  }
+
+  // the first member solving the instance or proving that it is
+  // unsolvable stops others
+  std::atomic<int> first(-1);
+  auto job = [&](const int k) {
+    members[k]->solve();
+    if (!members[k]->succeed() && !members[k]->isUnsolvable()) return;
+    int expected = -1;
+    if (first.compare_exchange_strong(expected, k)) race.cancel();
+  };
+  ThreadPool pool(members.size());
+  pool.run(job);
+
+  // collect results
+  for (auto& member : members) mergeStats(*member);
+  winner = first;
+  if (winner != -1) {
+    solved = members[winner]->succeed();
+    unsolvable = members[winner]->isUnsolvable();
+    solution = members[winner]->getSolution();
+    info(" ", members[winner]->getSolverName(), "finished first, elapsed:",
+         members[winner]->getCompTime());
+  }
+}
+
+void Portfolio::makeLogBasicInfo(std::ofstream& log)
+{
+  log << "winner_PORTFOLIO="
+      << (winner == -1 ? "none" : members[winner]->getSolverName()) << "\n";
+  for (auto& member : members) {
+    log << "comp_time_" << member->getSolverName()
+        << "_PORTFOLIO=" << member->getCompTime() << "\n";
+  }
+  Solver::makeLogBasicInfo(log);
+}
+
+void Portfolio::setParams(int argc, char* argv[])
+{
+  struct option longopts[] = {
+      {"distance-threads", required_argument, 0, 't'},
+      {"bit-parallel-bfs", no_argument, 0, 'w'},
+      {"compact-distance", no_argument, 0, 'z'},
+      {"lazy-distance", no_argument, 0, 'y'},
+      {"distance-cache", required_argument, 0, 'a'},
+      // long only, not in optstring
+      {"pp", required_argument, 0, 'x'},
+      {"dbs", required_argument, 0, 'u'},
+      {0, 0, 0, 0},
+  };
+
+  // options of members, except for --pp and --dbs
+  std::vector<char*> argv_members;
+  for (int k = 0; k < argc; ++k) {
+    const std::string arg(argv[k]);
+    if (arg == "--pp" || arg == "--dbs") {
+      ++k;  // skip the value
+      continue;
+    }
+    if (arg.rfind("--pp=", 0) == 0 || arg.rfind("--dbs=", 0) == 0) continue;
+    argv_members.push_back(argv[k]);
+  }
+
+  optind = 1;  // reset
+  int opt, longindex;
+  while ((opt = getopt_long(argc, argv, "t:wzya:", longopts, &longindex)) !=
+         -1) {
+    switch (opt) {
+      case 't':
+        distance_threads = std::atoi(optarg);
+        break;
+      case 'w':
+        bit_parallel_bfs = true;
+        break;
+      case 'z':
+        compact_distance = true;
+        break;
+      case 'y':
+        lazy_distance = true;
+        break;
+      case 'a':
+        distance_cache = std::string(optarg);
+        break;
+      case 'x':
+        members_params[0] = std::string(optarg);
+        break;
+      case 'u':
+        members_params[1] = std::string(optarg);
+        break;
+      default:
+        break;
+    }
+  }
+
+  // members read the distance table at the same time
+  if (lazy_distance) {
+    warn("-y is ignored, the full distance table is created for members");
+    lazy_distance = false;
+  }
+
+  // common options, then options only for each member
+  for (int k = 0; k < (int)members.size(); ++k) {
+    members[k]->setParams(argv_members.size(), argv_members.data());
+
+    std::vector<std::string> args = {members[k]->getSolverName()};
+    std::istringstream iss(members_params[k]);
+    std::string arg;
+    while (iss >> arg) args.push_back(arg);
+    if (args.size() == 1) continue;
+    std::vector<char*> argv_member;
+    for (auto& a : args) argv_member.push_back(&a[0]);
+    members[k]->setParams(argv_member.size(), argv_member.data());
+  }
+}
+
+void Portfolio::printHelp()
+{
+  std::cout << SOLVER_NAME << "\n"
+
+            << "  -t --distance-threads"
+            << "         "
+            << "threads for creating the shared distance table"
+
+            << "\n"
+
+            << "  -w --bit-parallel-bfs"
+            << "         "
+            << "create the distance table by 64 searches at once"
+
+            << "\n"
+
+            << "  -z --compact-distance"
+            << "         "
+            << "store distances as 16-bit integers"
+
+            << "\n"
+
+            << "  -y --lazy-distance"
+            << "            "
+            << "ignored, the shared distance table is always full"
+
+            << "\n"
+
+            << "  -a --distance-cache"
+            << "           "
+            << "load and store distances in the directory"
+
+            << "\n"
+
+            << "     --pp [OPTIONS]"
+            << "             "
+            << "options only for PP, e.g., --pp=\"-e -j 2\""
+
+            << "\n"
+
+            << "     --dbs [OPTIONS]"
+            << "            "
+            << "options only for DBS"
+
+            << "\n"
+
+            << "  other options of PP and DBS are given to both"
+
+            << std::endl;
+}
@@ -2,89 +2,267 @@
 
 #include <fstream>
 
+#include "../include/thread_pool.hpp"
+
 const std::string PP::SOLVER_NAME = "PP";
 
 PP::PP(Problem* _P)
     : Solver(_P),
       itr_cnt(0),
       iter_cnt_max(DEFAULT_ITER_CNT_MAX),
-      max_fragment_size(DEFAULT_MAX_FRAGMENT_SIZE)
+      max_fragment_size(DEFAULT_MAX_FRAGMENT_SIZE),
+      detection_threads(DEFAULT_DETECTION_THREADS),
+      cycle_detection(false),
+      scc_pruning(false),
+      fragments_limit(-1),
+      memory_budget(0),
+      prefix_restart(false),
+      registered_paths_cnt(0),
+      reused_paths_cnt(0),
+      threads(DEFAULT_THREADS),
+      root(this),
+      restarts_cnt(0),
+      winner(-1),
+      winner_itr_cnt(-1)
+{
+  solver_name = SOLVER_NAME;
+}
+
+PP::PP(PP* _root, const std::mt19937& _rng)
+    : Solver(_root->P, _rng),
+      itr_cnt(0),
+      iter_cnt_max(_root->iter_cnt_max),
+      max_fragment_size(_root->max_fragment_size),
+      detection_threads(_root->detection_threads),
+      cycle_detection(_root->cycle_detection),
+      scc_pruning(_root->scc_pruning),
+      fragments_limit(_root->fragments_limit),
+      memory_budget(_root->memory_budget),
+      prefix_restart(_root->prefix_restart),
+      registered_paths_cnt(0),
+      reused_paths_cnt(0),
+      threads(1),
+      root(_root),
+      restarts_cnt(0),
+      winner(-1),
+      winner_itr_cnt(-1)
 {
   solver_name = SOLVER_NAME;
+  distance_table = _root->distance_table;
+  // stopped by the root, or by the winner through cancel
+  deadline.reset(-1);
+  deadline.setParent(&_root->deadline);
 }
 
 PP::~PP() {}
 
 void PP::run()
+{
+  if (threads > 1) {
+    runWorkers();
+  } else {
+    runRestarts();
+    if (solved) {
+      winner = 0;
+      winner_itr_cnt = itr_cnt;
+    }
+  }
+}
+
+bool PP::countRestart()
+{
+  if (root->restarts_cnt++ >= iter_cnt_max) return false;
+  ++itr_cnt;
+  return true;
+}
+
+void PP::runWorkers()
+{
+  // worker-0 follows the same random sequence as a single thread, others
+  // use independent streams derived from the instance seed
+  std::vector<std::unique_ptr<PP>> workers;
+  for (int w = 0; w < threads; ++w) {
+    workers.push_back(std::unique_ptr<PP>(new PP(this, P->getRNG(w))));
+  }
+
+  std::atomic<int> first(-1);
+  auto job = [&](const int w) {
+    workers[w]->runRestarts();
+    if (!workers[w]->solved) return;
+    int expected = -1;
+    if (!first.compare_exchange_strong(expected, w)) return;
+    for (int k = 0; k < threads; ++k) {
+      if (k != w) workers[k]->cancel();
+    }
+  };
+  ThreadPool pool(threads);
+  pool.run(job);
+
+  // collect results
+  for (auto& worker : workers) {
+    itr_cnt += worker->itr_cnt;
+    registered_paths_cnt += worker->registered_paths_cnt;
+    reused_paths_cnt += worker->reused_paths_cnt;
+    mergeStats(*worker);
+  }
+  winner = first;
+  if (winner != -1) {
+    solved = true;
+    solution = workers[winner]->solution;
+    winner_itr_cnt = workers[winner]->itr_cnt;
+    info(" ", "worker-" + std::to_string(winner), "solved at iter",
+         winner_itr_cnt, ", total iter:", itr_cnt);
+  }
+}
+
+void PP::runRestarts()
 {
   // id_list
   std::vector<int> id_list(P->getNum());
   std::iota(id_list.begin(), id_list.end(), 0);
 
-  while (!solved && !overCompTime() && itr_cnt < iter_cnt_max) {
-    ++itr_cnt;
+  // table of the current priority order, kept over iterations with
+  // prefix restart, and its states before registering each agent
+  TableFragment* table = nullptr;
+  std::vector<TableFragment::Checkpoint> checkpoints;
+  const bool use_checkpoints =
+      prefix_restart && !cycle_detection && !scc_pruning;
+  int k = 0;  // position to start planning
 
-    // randomize order
-    std::shuffle(id_list.begin(), id_list.end(), *MT);
+  while (!solved && !overCompTime() && countRestart()) {
+    if (table == nullptr) {
+      // randomize order
+      std::shuffle(id_list.begin(), id_list.end(), *MT);
 
-    // initialize
-    solution.clear();
-    solution.resize(P->getNum());
+      // initialize
+      solution.clear();
+      solution.resize(P->getNum());
+      table = new TableFragment(G, max_fragment_size, csr);
+      setupTable(table);
+      checkpoints.clear();
+      k = 0;
+    }
 
-    info(" ", "iter-" + std::to_string(itr_cnt), "start");
+    info(" ", "iter-" + std::to_string(itr_cnt), "start", ", reuse:", k);
+    reused_paths_cnt += k;
 
     // main
-    bool invalid = false;
-    auto table = new TableFragment(G, max_fragment_size);
-    for (int j = 0; j < P->getNum(); ++j) {
-      const int i = id_list[j];
-
-      info(" ", "elapsed:", getSolverElapsedTime(), ", iter:", itr_cnt,
-           ", agent-" + std::to_string(i), "starts planning,",
-           "init-dist:", pathDist(i), ", progress:", j + 1, "/", P->getNum());
-
-      // get prioritized path
-      auto t_p = Time::now();
-      solution[i] = getPrioritizedPath(i, solution, *table);
-      elapsed_time_pathfinding += getElapsedTime(t_p);
-
-      // failed
-      if (solution[i].empty() || overCompTime()) {
-        invalid = true;
-        break;
-      }
+    const int j_failed =
+        planAgents(id_list, k, table, use_checkpoints ? &checkpoints : nullptr);
+    solved = j_failed == -1;
 
-      // register new path
+    // restart from scratch
+    if (solved || !prefix_restart || j_failed == 0 || overCompTime()) {
       auto t_d = Time::now();
-      auto c = table->registerNewPath(i, solution[i], false, getRemainedTime());
+      fragment_stats.merge(table->getStats());
+      delete table;
+      table = nullptr;
       elapsed_time_deadlock_detection += getElapsedTime(t_d);
-      if (c != nullptr) halt("detect deadlock");
+      continue;
     }
-    solved = !invalid;
 
+    // move the failed agent forward, the prefix before it is kept
     auto t_d = Time::now();
+    k = getRandomInt(0, j_failed - 1, MT);
+    if (use_checkpoints) {
+      table->rollback(checkpoints[k]);
+      checkpoints.resize(k);
+    } else {
+      for (int j = j_failed - 1; j >= k; --j) table->unregisterPath(id_list[j]);
+    }
+    elapsed_time_deadlock_detection += getElapsedTime(t_d);
+    for (int j = k; j <= j_failed; ++j) solution[id_list[j]].clear();
+    std::rotate(id_list.begin() + k, id_list.begin() + j_failed,
+                id_list.begin() + j_failed + 1);
+  }
+
+  if (table != nullptr) {
+    fragment_stats.merge(table->getStats());
     delete table;
+  }
+}
+
+int PP::planAgents(const std::vector<int>& id_list, const int k,
+                   TableFragment* table,
+                   std::vector<TableFragment::Checkpoint>* checkpoints)
+{
+  for (int j = k; j < P->getNum(); ++j) {
+    const int i = id_list[j];
+
+    info(" ", "elapsed:", getSolverElapsedTime(), ", iter:", itr_cnt,
+         ", agent-" + std::to_string(i), "starts planning,",
+         "init-dist:", pathDist(i), ", progress:", j + 1, "/", P->getNum());
+
+    // get prioritized path
+    auto t_p = Time::now();
+    solution[i] = getPrioritizedPath(i, solution, *table);
+    elapsed_time_pathfinding += getElapsedTime(t_p);
+
+    // failed
+    if (solution[i].empty() || overCompTime()) return j;
+
+    // register new path
+    auto t_d = Time::now();
+    if (checkpoints != nullptr) checkpoints->push_back(table->getCheckpoint());
+    auto c = table->registerNewPath(i, solution[i], false, &deadline);
+    ++registered_paths_cnt;
     elapsed_time_deadlock_detection += getElapsedTime(t_d);
+    if (c != nullptr) halt("detect deadlock");
+
+    // fail fast
+    if (table->isOverLimit()) {
+      info(" ", "exceed the limit of fragments");
+      cancel();
+      return j;
+    }
   }
+  return -1;
 }
 
 void PP::makeLogBasicInfo(std::ofstream& log)
 {
   log << "repetation_PP=" << itr_cnt << "\n";
+  log << "threads_PP=" << threads << "\n";
+  log << "winner_PP=" << winner << "\n";
+  log << "winner_repetation_PP=" << winner_itr_cnt << "\n";
+  log << "registered_paths_PP=" << registered_paths_cnt << "\n";
+  log << "reused_paths_PP=" << reused_paths_cnt << "\n";
   Solver::makeLogBasicInfo(log);
 }
 
+void PP::setupTable(TableFragment* table) const
+{
+  table->setThreadsNum(detection_threads);
+  table->setCycleDetection(cycle_detection);
+  table->setSccPruning(scc_pruning);
+  table->setFragmentsLimit(fragments_limit);
+  table->setMemoryBudget((std::size_t)memory_budget << 20);
+}
+
 void PP::setParams(int argc, char* argv[])
 {
   struct option longopts[] = {
       {"iter-cnt-max", required_argument, 0, 'm'},
       {"max-fragment-size", required_argument, 0, 'f'},
+      {"detection-threads", required_argument, 0, 'd'},
+      {"cycle-detection", no_argument, 0, 'c'},
+      {"scc-pruning", no_argument, 0, 'g'},
+      {"fragments-limit", required_argument, 0, 'l'},
+      {"memory-budget", required_argument, 0, 'b'},
+      {"prefix-restart", no_argument, 0, 'e'},
+      {"distance-threads", required_argument, 0, 't'},
+      {"bit-parallel-bfs", no_argument, 0, 'w'},
+      {"compact-distance", no_argument, 0, 'z'},
+      {"lazy-distance", no_argument, 0, 'y'},
+      {"distance-cache", required_argument, 0, 'a'},
+      {"threads", required_argument, 0, 'j'},
       {0, 0, 0, 0},
   };
 
   optind = 1;  // reset
   int opt, longindex;
-  while ((opt = getopt_long(argc, argv, "m:f:", longopts, &longindex)) != -1) {
+  while ((opt = getopt_long(argc, argv, "m:f:d:cgl:b:et:wzya:j:", longopts,
+                            &longindex)) != -1) {
     switch (opt) {
       case 'm':
         iter_cnt_max = std::atoi(optarg);
@@ -92,10 +270,55 @@ void PP::setParams(int argc, char* argv[])
       case 'f':
         max_fragment_size = std::atoi(optarg);
         break;
+      case 'd':
+        detection_threads = std::atoi(optarg);
+        break;
+      case 'c':
+        cycle_detection = true;
+        break;
+      case 'g':
+        scc_pruning = true;
+        break;
+      case 'l':
+        fragments_limit = std::atoi(optarg);
+        break;
+      case 'b':
+        memory_budget = std::atoi(optarg);
+        break;
+      case 'e':
+        prefix_restart = true;
+        break;
+      case 't':
+        distance_threads = std::atoi(optarg);
+        break;
+      case 'w':
+        bit_parallel_bfs = true;
+        break;
+      case 'z':
+        compact_distance = true;
+        break;
+      case 'y':
+        lazy_distance = true;
+        break;
+      case 'a':
+        distance_cache = std::string(optarg);
+        break;
+      case 'j':
+        threads = std::atoi(optarg);
+        break;
       default:
         break;
     }
   }
+
+  // the tie-break of A* counts all fragments of the table
+  if (scc_pruning) {
+    warn("-g is ignored, ties of A* are broken by all fragments");
+    scc_pruning = false;
+  }
+
+  // workers read the distance table at the same time
+  if (threads > 1) lazy_distance = false;
 }
 
 void PP::printHelp()
@@ -112,5 +335,77 @@ void PP::printHelp()
             << "        "
             << "maximum fragment size"
 
+            << "\n"
+
+            << "  -d --detection-threads"
+            << "        "
+            << "threads for deadlock detection"
+
+            << "\n"
+
+            << "  -c --cycle-detection"
+            << "          "
+            << "detect cycles without enumerating fragments"
+
+            << "\n"
+
+            << "  -g --scc-pruning"
+            << "              "
+            << "ignored, only for DBS"
+
+            << "\n"
+
+            << "  -l --fragments-limit"
+            << "          "
+            << "fail when the number of fragments reaches this"
+
+            << "\n"
+
+            << "  -b --memory-budget"
+            << "            "
+            << "fail when fragments use this memory (MB)"
+
+            << "\n"
+
+            << "  -e --prefix-restart"
+            << "           "
+            << "keep the prefix of priorities until the failed agent"
+
+            << "\n"
+
+            << "  -t --distance-threads"
+            << "         "
+            << "threads for creating the distance table"
+
+            << "\n"
+
+            << "  -w --bit-parallel-bfs"
+            << "         "
+            << "create the distance table by 64 searches at once"
+
+            << "\n"
+
+            << "  -z --compact-distance"
+            << "         "
+            << "store distances as 16-bit integers"
+
+            << "\n"
+
+            << "  -y --lazy-distance"
+            << "            "
+            << "compute distances of each goal when first used"
+
+            << "\n"
+
+            << "  -a --distance-cache"
+            << "           "
+            << "load and store distances in the directory"
+
+            << "\n"
+
+            << "  -j --threads"
+            << "                  "
+            << "run restarts on threads, the first success stops others"
+
             << std::endl;
 }
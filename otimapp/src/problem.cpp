@@ -12,7 +12,9 @@ Problem::Problem(const std::string& _instance)
       seed(DEFAULT_SEED),
       MT(nullptr),
       max_comp_time(DEFAULT_MAX_COMP_TIME),
-      is_random_graph(false)
+      is_random_graph(false),
+      csr(nullptr),
+      node_order(CSRGraph::ID)
 {
   // read instance file
   std::ifstream file(instance);
@@ -125,7 +127,9 @@ Problem::Problem(int _nodes_size, float _prob, int _num_agents, int _seed = 0)
       MT(new std::mt19937(_seed)),
       num_agents(_num_agents),
       max_comp_time(DEFAULT_MAX_COMP_TIME),
-      is_random_graph(true)
+      is_random_graph(true),
+      csr(nullptr),
+      node_order(CSRGraph::ID)
 {
   setGoalAvoidanceInstance();
 }
@@ -134,6 +138,30 @@ Problem::~Problem()
 {
   if (G != nullptr) delete G;
   if (MT != nullptr) delete MT;
+  if (csr != nullptr) delete csr;
+}
+
+const CSRGraph* Problem::getCSR()
+{
+  std::call_once(csr_flag, [&]() {
+    auto _csr = new CSRGraph(G, node_order);
+    _csr->setGoals(config_g);
+    csr = _csr;
+  });
+  return csr;
+}
+
+std::mt19937 Problem::getRNG(const int stream) const
+{
+  if (stream == 0) return *MT;
+  std::seed_seq seq{seed, stream};
+  return std::mt19937(seq);
+}
+
+void Problem::setNodeOrder(const CSRGraph::Order order)
+{
+  if (csr != nullptr) halt("node order is fixed after solvers are created");
+  node_order = order;
 }
 
 Node* Problem::getStart(int i) const
@@ -4,11 +4,16 @@
 #include <iomanip>
 #include <typeinfo>
 
-MinimumSolver::MinimumSolver(Problem* _P)
+MinimumSolver::MinimumSolver(Problem* _P) : MinimumSolver(_P, _P->getRNG())
+{
+}
+
+MinimumSolver::MinimumSolver(Problem* _P, const std::mt19937& _rng)
     : solver_name(""),
       P(_P),
       G(_P->getG()),
-      MT(_P->getMT()),
+      rng(_rng),
+      MT(&rng),
       max_comp_time(P->getMaxCompTime()),
       solved(false),
       unsolvable(false),
@@ -23,7 +28,11 @@ void MinimumSolver::solve()
   end();
 }
 
-void MinimumSolver::start() { t_start = Time::now(); }
+void MinimumSolver::start()
+{
+  t_start = Time::now();
+  deadline.reset(max_comp_time);
+}
 
 void MinimumSolver::end() { comp_time = getSolverElapsedTime(); }
 
@@ -36,12 +45,17 @@ int MinimumSolver::getSolverElapsedTime() const
 // base class with utilities
 // -----------------------------------------------
 
-Solver::Solver(Problem* _P)
-    : MinimumSolver(_P),
+Solver::Solver(Problem* _P) : Solver(_P, _P->getRNG()) {}
+
+Solver::Solver(Problem* _P, const std::mt19937& _rng)
+    : MinimumSolver(_P, _rng),
       verbose(false),
-      distance_table(P->getNum(),
-                     std::vector<int>(G->getNodesSize(), G->getNodesSize())),
-      table_goals(G->getNodesSize(), false),
+      distance_threads(DEFAULT_DISTANCE_THREADS),
+      bit_parallel_bfs(false),
+      compact_distance(false),
+      lazy_distance(false),
+      distance_cache(""),
+      csr(P->getCSR()),
       elapsed_time_pathfinding(0),
       elapsed_time_deadlock_detection(0)
 {
@@ -54,28 +68,30 @@ Solver::~Solver() {}
 // -------------------------------
 void Solver::exec()
 {
-  // create distance table
-  info("  pre-processing, create distance table by BFS & create goal table");
-  createDistanceTable();
-  for (int i = 0; i < P->getNum(); ++i) table_goals[P->getGoal(i)->id] = true;
-  info("  done, elapsed: ", getSolverElapsedTime());
+  // create distance table, unless shared by another solver
+  if (distance_table == nullptr) {
+    info("  pre-processing, create distance table by BFS");
+    createDistanceTable();
+    info("  done, elapsed: ", getSolverElapsedTime());
+  }
 
   // main
   run();
 }
 
+void Solver::mergeStats(const Solver& other)
+{
+  elapsed_time_pathfinding += other.elapsed_time_pathfinding;
+  elapsed_time_deadlock_detection += other.elapsed_time_deadlock_detection;
+  fragment_stats.merge(other.fragment_stats);
+}
+
 // -------------------------------
 // utilities for time
 // -------------------------------
-int Solver::getRemainedTime() const
-{
-  return std::max(0, max_comp_time - getSolverElapsedTime());
-}
+int Solver::getRemainedTime() const { return deadline.getRemainedTime(); }
 
-bool Solver::overCompTime() const
-{
-  return getSolverElapsedTime() >= max_comp_time;
-}
+bool Solver::overCompTime() { return deadline.expiredNow(); }
 
 // -------------------------------
 // utilities for debug
@@ -125,6 +141,18 @@ void Solver::makeLogBasicInfo(std::ofstream& log)
   log << "elapsed_pathfinding=" << elapsed_time_pathfinding << "\n";
   log << "elapsed_deadlock_detection=" << elapsed_time_deadlock_detection
       << "\n";
+  log << "fragments_created=" << fragment_stats.created << "\n";
+  log << "fragments_duplicates=" << fragment_stats.duplicates << "\n";
+  log << "fragments_topology_rejections=" << fragment_stats.topology << "\n";
+  log << "fragments_peak=" << fragment_stats.peak_fragments << "\n";
+  log << "fragments_peak_bytes=" << fragment_stats.peak_bytes << "\n";
+  log << "fragments_max_bucket_from=" << fragment_stats.max_bucket_from
+      << "\n";
+  log << "fragments_max_bucket_to=" << fragment_stats.max_bucket_to << "\n";
+  log << "fragments_length_hist=";
+  for (auto cnt : fragment_stats.length_hist) log << cnt << ",";
+  log << "\n";
+  log << "fragments_over_limit=" << fragment_stats.over_limit << "\n";
 }
 
 void Solver::makeLogSolution(std::ofstream& log)
@@ -184,33 +212,14 @@ void Solver::printHelpWithoutOption(const std::string& solver_name)
 // -------------------------------
 // distance
 // -------------------------------
-int Solver::pathDist(const int i, Node* const s) const
-{
-  return distance_table[i][s->id];
-}
-
-int Solver::pathDist(const int i) const { return pathDist(i, P->getStart(i)); }
+int Solver::pathDist(const int i) { return pathDist(i, P->getStart(i)); }
 
 void Solver::createDistanceTable()
 {
-  for (int i = 0; i < P->getNum(); ++i) {
-    // breadth first search
-    std::queue<Node*> OPEN;
-    Node* n = P->getGoal(i);
-    OPEN.push(n);
-    distance_table[i][n->id] = 0;
-    while (!OPEN.empty()) {
-      n = OPEN.front();
-      OPEN.pop();
-      const int d_n = distance_table[i][n->id];
-      for (auto m : n->neighbor) {
-        const int d_m = distance_table[i][m->id];
-        if (d_n + 1 >= d_m) continue;
-        distance_table[i][m->id] = d_n + 1;
-        OPEN.push(m);
-      }
-    }
-  }
+  if (distance_table != nullptr) return;  // shared by another solver
+  distance_table = std::make_shared<DistanceTable>(
+      P, compact_distance, lazy_distance, distance_cache);
+  distance_table->create(distance_threads, bit_parallel_bfs, &deadline);
 }
 
 // -------------------------------
@@ -226,70 +235,7 @@ Solver::CompareAstarNodes Solver::compareAstarNodesDefault = [](AstarNode* a,
 Path Solver::getPath(const int id, CheckInvalidMove checkInvalidNode,
                      CompareAstarNodes compare)
 {
-  Node* const s = P->getStart(id);
-  Node* const g = P->getGoal(id);
-
-  AstarNodes GC;  // garbage collection
-  auto createNewNode = [&GC](Node* v, int g, int f, AstarNode* p) {
-    AstarNode* new_node = new AstarNode{v, g, f, p};
-    GC.push_back(new_node);
-    return new_node;
-  };
-
-  // OPEN and CLOSE list
-  std::priority_queue<AstarNode*, AstarNodes, decltype(compare)> OPEN(compare);
-  std::vector<bool> CLOSE(G->getNodesSize(), false);
-
-  // initial node
-  AstarNode* n = createNewNode(s, 0, pathDist(id, s), nullptr);
-  OPEN.push(n);
-
-  // main loop
-  bool invalid = true;
-  while (!OPEN.empty()) {
-    // check time limit
-    if (overCompTime()) break;
-
-    // minimum node
-    n = OPEN.top();
-    OPEN.pop();
-
-    // check CLOSE list
-    if (CLOSE[n->v->id]) continue;
-    CLOSE[n->v->id] = true;
-
-    // check goal condition
-    if (n->v == g) {
-      invalid = false;
-      break;
-    }
-
-    // expand
-    Nodes C = n->v->neighbor;
-    std::shuffle(C.begin(), C.end(), *MT);  // randomize
-    for (auto u : C) {
-      // already searched?
-      if (CLOSE[u->id]) continue;
-      // check constraints
-      if (checkInvalidNode(u, n->v)) continue;
-      int g_cost = n->g + 1;
-      OPEN.push(createNewNode(u, g_cost, g_cost + pathDist(id, u), n));
-    }
-  }
-
-  Path path;
-  if (!invalid) {  // success
-    while (n != nullptr) {
-      path.push_back(n->v);
-      n = n->p;
-    }
-    std::reverse(path.begin(), path.end());
-  }
-
-  // free
-  for (auto p : GC) delete p;
-
-  return path;
+  return getPathWithPolicy(id, checkInvalidNode, compare);
 }
 
 Path Solver::getPrioritizedPath(const int id, const Plan& paths,
@@ -299,9 +245,9 @@ Path Solver::getPrioritizedPath(const int id, const Plan& paths,
 
   auto compare = [&](AstarNode* a, AstarNode* b) {
     if (a->f != b->f) return a->f > b->f;
-    // tie break
-    int fragments_a = table.t_from[a->v->id].size();
-    int fragments_b = table.t_from[b->v->id].size();
+    // tie break, fewer fragments (moves with cycle detection) from the node
+    int fragments_a = table.countFrom(a->v->id);
+    int fragments_b = table.countFrom(b->v->id);
     if (fragments_a != fragments_b) return fragments_a > fragments_b;
     if (a->g != b->g) return a->g < b->g;
     return a->v->id < b->v->id;
@@ -309,15 +255,14 @@ Path Solver::getPrioritizedPath(const int id, const Plan& paths,
 
   auto checkInvalidNode = [&](Node* child, Node* parent) {
     // condition 1, avoid goals
-    if (child != g && table_goals[child->id]) return true;
+    if (child != g && csr->isGoal(child)) return true;
 
     // condition 2, avoid potential deadlocks
-    for (auto c : table.t_to[parent->id]) {
-      if (c->path.front() == child) return true;
-    }
-
-    return false;
+    return table.existPotentialDeadlock(id, parent, child);
   };
 
-  return getPath(id, checkInvalidNode, compare);
+  // buckets of f-values, the comparator breaks ties
+  auto getKey = [](AstarNode* a) { return a->f; };
+
+  return getPathWithPolicy(id, checkInvalidNode, compare, getKey);
 }
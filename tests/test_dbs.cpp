@@ -10,3 +10,17 @@ TEST(DBS, solve)
 
   ASSERT_TRUE(solver->succeed());
 }
+
+TEST(DBS, sccPruning)
+{
+  // pruning only for finding constraints
+  char argv0[] = "DBS";
+  char argv1[] = "-g";
+  char* argv_solver[] = {argv0, argv1};
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver = std::make_unique<DBS>(&P);
+  solver->setParams(2, argv_solver);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+}
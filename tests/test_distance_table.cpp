@@ -0,0 +1,96 @@
+#include <distance_table.hpp>
+#include <filesystem>
+
+#include "gtest/gtest.h"
+
+// number of files in the directory with the extension
+static int countFiles(const std::string& dir, const std::string& ext)
+{
+  int cnt = 0;
+  for (auto& entry : std::filesystem::directory_iterator(dir)) {
+    if (entry.path().extension() == ext) ++cnt;
+  }
+  return cnt;
+}
+
+TEST(DistanceTable, modes)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  Graph* G = P.getG();
+
+  DistanceTable D1(&P);
+  D1.create();
+  DistanceTable D2(&P, true);
+  D2.create(2);
+  DistanceTable D3(&P, true, true);
+  D3.create();
+  DistanceTable D4(&P, false, false);
+  D4.create(1, true);
+
+  ASSERT_TRUE(D2.isCompact());
+  ASSERT_LT(D2.getBytes(), D1.getBytes());
+
+  // rows of lazy mode are computed when accessed
+  ASSERT_EQ(D3.getComputedRowsNum(), 0);
+  ASSERT_EQ(D3.get(0, P.getStart(0)->id),
+            G->pathDist(P.getStart(0), P.getGoal(0)));
+  ASSERT_EQ(D3.getComputedRowsNum(), 1);
+
+  for (int i = 0; i < P.getNum(); ++i) {
+    for (int v = 0; v < G->getNodesSize(); ++v) {
+      const int d = D1.get(i, v);
+      ASSERT_EQ(D2.get(i, v), d);
+      ASSERT_EQ(D3.get(i, v), d);
+      ASSERT_EQ(D4.get(i, v), d);
+    }
+  }
+  ASSERT_EQ(D3.getComputedRowsNum(), D3.getRowsNum());
+  ASSERT_EQ(D1.get(0, P.getGoal(0)->id), 0);
+}
+
+TEST(DistanceTable, sharedGoals)
+{
+  Problem P = Problem("../tests/instances/shared_goals.txt");
+  Graph* G = P.getG();
+
+  // agents 0 and 1 share the goal
+  DistanceTable D(&P, true);
+  D.create();
+  ASSERT_EQ(D.getRowsNum(), 2);
+  for (int i = 0; i < P.getNum(); ++i) {
+    ASSERT_EQ(D.get(i, P.getStart(i)->id),
+              G->pathDist(P.getStart(i), P.getGoal(i)));
+  }
+}
+
+TEST(DistanceTable, cache)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  // nested directories are created, files of previous runs are removed so
+  // that the first table always writes
+  const std::string cache_root = "./distance_cache_test";
+  const std::string cache_dir = cache_root + "/nested/dir";
+  std::filesystem::remove_all(cache_root);
+
+  DistanceTable D1(&P);
+  D1.create();
+  for (auto compact : {false, true}) {
+    // the first one writes rows, the second one reads them
+    DistanceTable D2(&P, compact, false, cache_dir);
+    D2.create();
+    // one file for each row, no temporary files are left
+    ASSERT_EQ(countFiles(cache_dir, compact ? ".d16" : ".d32"),
+              D2.getRowsNum());
+    ASSERT_EQ(countFiles(cache_dir, ".d16") + countFiles(cache_dir, ".d32"),
+              std::distance(std::filesystem::directory_iterator(cache_dir),
+                            std::filesystem::directory_iterator()));
+    DistanceTable D3(&P, compact, true, cache_dir);
+    for (int i = 0; i < P.getNum(); ++i) {
+      for (int v = 0; v < P.getG()->getNodesSize(); ++v) {
+        ASSERT_EQ(D2.get(i, v), D1.get(i, v));
+        ASSERT_EQ(D3.get(i, v), D1.get(i, v));
+      }
+    }
+  }
+  std::filesystem::remove_all(cache_root);
+}
@@ -1,4 +1,5 @@
 #include <execution.hpp>
+#include <pp.hpp>
 
 #include "gtest/gtest.h"
 
@@ -16,3 +17,65 @@ TEST(PrimitiveExecution, basic)
   auto exec = PrimitiveExecution(&P, "../tests/instances/toy_problem_plan.txt");
   exec.run();
 }
+
+TEST(Execution, nodeOrder)
+{
+  // plan without deadlocks
+  const std::string plan_file = "./execution_test_plan.txt";
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver = std::make_unique<PP>(&P);
+  solver->solve();
+  ASSERT_TRUE(solver->succeed());
+  solver->makeLog(plan_file);
+
+  // the same execution on any indices of the CSR graph
+  Problem P_hilbert = Problem("../tests/instances/example.txt");
+  P_hilbert.setNodeOrder(CSRGraph::HILBERT);
+  for (int seed = 0; seed < 10; ++seed) {
+    auto exec = MAPF_DP_Execution(&P, plan_file, seed, 0.5);
+    auto exec_hilbert = MAPF_DP_Execution(&P_hilbert, plan_file, seed, 0.5);
+    exec.run();
+    exec_hilbert.run();
+    ASSERT_TRUE(exec.getExecSucceed());
+    ASSERT_TRUE(exec_hilbert.getExecSucceed());
+
+    auto result = exec.getExecResult();
+    auto result_hilbert = exec_hilbert.getExecResult();
+    ASSERT_EQ(result.size(), result_hilbert.size());
+    for (int t = 0; t < (int)result.size(); ++t) {
+      for (int i = 0; i < P.getNum(); ++i) {
+        ASSERT_EQ(result[t][i]->id, result_hilbert[t][i]->id);
+      }
+    }
+  }
+  std::remove(plan_file.c_str());
+}
+
+TEST(Execution, validateMAPFPlan)
+{
+  Problem P = Problem("../tests/instances/toy_problem.txt");
+  Graph* G = P.getG();
+  auto getConfigs = [&](const std::vector<std::vector<int>>& ids) {
+    Configs configs;
+    for (auto& c : ids) {
+      Config config;
+      for (auto id : c) config.push_back(G->getNode(id));
+      configs.push_back(config);
+    }
+    return configs;
+  };
+
+  ASSERT_TRUE(validateMAPFPlan(getConfigs({{0, 9}, {1, 8}}), &P));
+  ASSERT_TRUE(validateMAPFPlan(getConfigs({{0, 9}, {1, 9}, {1, 8}}), &P));
+  // vertex conflict
+  ASSERT_FALSE(
+      validateMAPFPlan(getConfigs({{0, 9}, {1, 9}, {9, 9}, {1, 8}}), &P));
+  // swap conflict
+  ASSERT_FALSE(validateMAPFPlan(
+      getConfigs({{0, 9}, {1, 9}, {9, 1}, {1, 9}, {1, 8}}), &P));
+  // not neighbors
+  ASSERT_FALSE(
+      validateMAPFPlan(getConfigs({{0, 9}, {1, 9}, {1, 0}, {1, 8}}), &P));
+  // wrong goals
+  ASSERT_FALSE(validateMAPFPlan(getConfigs({{0, 9}, {1, 9}}), &P));
+}
@@ -2,6 +2,38 @@
 
 #include "gtest/gtest.h"
 
+// shortest paths between random pairs of nodes
+static std::vector<Path> getRandomPaths(Grid& G, const int num,
+                                        const int seed)
+{
+  std::mt19937 MT(seed);
+  std::vector<Path> paths;
+  while ((int)paths.size() < num) {
+    auto s = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    auto g = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    if (s == nullptr || g == nullptr || s == g) continue;
+    paths.push_back(G.getPath(s, g));
+  }
+  return paths;
+}
+
+// all fragments as (path, sorted agents), independent of creation order
+using FragmentSet = std::vector<std::pair<std::vector<int>, std::vector<int>>>;
+static FragmentSet getFragmentSet(const TableFragment& table)
+{
+  FragmentSet res;
+  for (auto& arr : table.t_from) {
+    for (auto c : arr) {
+      std::vector<int> agents(c->agents.begin(), c->agents.end());
+      std::sort(agents.begin(), agents.end());
+      res.emplace_back(std::vector<int>(c->path.begin(), c->path.end()),
+                       agents);
+    }
+  }
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
 TEST(TableFragment, registerNewPath)
 {
   auto G = Grid("8x8.map");
@@ -20,4 +52,389 @@ TEST(TableFragment, registerNewPath)
              G.getNode(8)};
   auto c3 = table.registerNewPath(2, p3);
   ASSERT_EQ(c3, nullptr);
+
+  // statistics
+  ASSERT_GT(table.getLiveFragmentsNum(), 0);
+  ASSERT_GE(table.getArenaBytes(),
+            table.getLiveFragmentsNum() * sizeof(Fragment));
+}
+
+TEST(TableFragment, unregisterPath)
+{
+  auto G = Grid("8x8.map");
+  auto table = TableFragment(&G);
+
+  Path p1 = {G.getNode(0), G.getNode(1), G.getNode(2)};
+  Path p2 = {G.getNode(3), G.getNode(2), G.getNode(1)};
+  Path p3 = {G.getNode(10), G.getNode(2), G.getNode(3)};
+  ASSERT_EQ(table.registerNewPath(0, p1), nullptr);
+  const int fragments_num = table.getLiveFragmentsNum();
+  ASSERT_NE(table.registerNewPath(1, p2), nullptr);
+  const int created_num = table.getFragmentsNum();
+
+  // remove fragments of agent-1, created ones are still counted
+  table.unregisterPath(1);
+  ASSERT_EQ(table.getLiveFragmentsNum(), fragments_num);
+  ASSERT_EQ(table.getFragmentsNum(), created_num);
+  ASSERT_GT(created_num, fragments_num);
+  ASSERT_TRUE(table.t_agent[1].empty());
+
+  // replace the path of agent-1
+  ASSERT_EQ(table.registerNewPath(1, p3), nullptr);
+}
+
+TEST(TableFragment, rollback)
+{
+  auto G = Grid("8x8.map");
+  auto table = TableFragment(&G);
+
+  Path p1 = {G.getNode(0), G.getNode(1), G.getNode(2)};
+  Path p2 = {G.getNode(3), G.getNode(2), G.getNode(1)};
+  Path p3 = {G.getNode(10), G.getNode(2), G.getNode(3)};
+  ASSERT_EQ(table.registerNewPath(0, p1), nullptr);
+  ASSERT_EQ(table.registerNewPath(2, p3), nullptr);
+  const int fragments_num = table.getLiveFragmentsNum();
+  const auto bytes = table.getArenaBytes();
+  const auto t_from_2 = table.t_from[2];
+
+  auto checkpoint = table.getCheckpoint();
+  table.unregisterPath(0);
+  ASSERT_NE(table.registerNewPath(1, p2), nullptr);
+  table.rollback(checkpoint);
+
+  ASSERT_EQ(table.getLiveFragmentsNum(), fragments_num);
+  ASSERT_EQ(table.getArenaBytes(), bytes);
+  ASSERT_EQ(table.t_from[2], t_from_2);
+  ASSERT_TRUE(table.t_agent[1].empty());
+
+  // the same deadlock is detected again
+  ASSERT_NE(table.registerNewPath(1, p2), nullptr);
+}
+
+TEST(TableFragment, multiThreads)
+{
+  auto G = Grid("random-32-32-10.map");
+  std::mt19937 MT(0);
+  std::vector<Path> paths;
+  while (paths.size() < 100) {
+    auto s = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    auto g = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    if (s == nullptr || g == nullptr || s == g) continue;
+    paths.push_back(G.getPath(s, g));
+  }
+
+  // register all, results are independent of the number of threads
+  for (auto force : {true, false}) {
+    auto table_seq = TableFragment(&G, 4);
+    auto table_par = TableFragment(&G, 4);
+    table_par.setThreadsNum(4);
+    for (int i = 0; i < (int)paths.size(); ++i) {
+      auto c_seq = table_seq.registerNewPath(i, paths[i], force);
+      auto c_par = table_par.registerNewPath(i, paths[i], force);
+      ASSERT_EQ(table_seq.getFragmentsNum(), table_par.getFragmentsNum());
+      if (force) continue;
+      ASSERT_EQ(c_seq == nullptr, c_par == nullptr);
+      if (c_seq == nullptr) continue;
+      ASSERT_EQ(std::vector<int>(c_seq->path.begin(), c_seq->path.end()),
+                std::vector<int>(c_par->path.begin(), c_par->path.end()));
+      ASSERT_EQ(std::vector<int>(c_seq->agents.begin(), c_seq->agents.end()),
+                std::vector<int>(c_par->agents.begin(), c_par->agents.end()));
+      break;
+    }
+    ASSERT_EQ(table_seq.t_cycle.size(), table_par.t_cycle.size());
+  }
+}
+
+TEST(TableFragment, deadline)
+{
+  auto G = Grid("8x8.map");
+  auto table = TableFragment(&G);
+
+  Path p1 = {G.getNode(0), G.getNode(1)};
+  Path p2 = {G.getNode(1), G.getNode(0)};
+  ASSERT_EQ(table.registerNewPath(0, p1), nullptr);
+
+  // cancelled from outside
+  Deadline deadline;
+  deadline.cancel();
+  ASSERT_EQ(table.registerNewPath(1, p2, false, &deadline), nullptr);
+  ASSERT_EQ(table.getFragmentsNum(), 1);
+
+  // no time limit
+  deadline.reset(-1);
+  ASSERT_NE(table.registerNewPath(1, p2, false, &deadline), nullptr);
+}
+
+TEST(TableFragment, cycleDetection)
+{
+  auto G = Grid("random-32-32-10.map");
+  std::mt19937 MT(1);
+  std::vector<Path> paths;
+  while (paths.size() < 30) {
+    auto s = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    auto g = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    if (s == nullptr || g == nullptr || s == g) continue;
+    paths.push_back(G.getPath(s, g));
+  }
+
+  // same results as fragments
+  auto table_frg = TableFragment(&G, 4);
+  auto table_cyc = TableFragment(&G, 4);
+  table_cyc.setCycleDetection(true);
+  ASSERT_TRUE(table_cyc.isCycleDetection());
+  for (int i = 0; i < (int)paths.size(); ++i) {
+    table_frg.registerNewPath(i, paths[i], true);
+    table_cyc.registerNewPath(i, paths[i], true);
+    auto c_frg = table_frg.getPotentialDeadlock();
+    auto c_cyc = table_cyc.getPotentialDeadlock();
+    ASSERT_EQ(c_frg == nullptr, c_cyc == nullptr);
+    if (c_cyc == nullptr) continue;
+    // witness is a cycle with distinct agents
+    ASSERT_EQ(c_cyc->path.front(), c_cyc->path.back());
+    ASSERT_LE(c_cyc->agents.size(), 4);
+    auto agents = std::vector<int>(c_cyc->agents.begin(), c_cyc->agents.end());
+    std::sort(agents.begin(), agents.end());
+    ASSERT_EQ(std::unique(agents.begin(), agents.end()), agents.end());
+  }
+
+  // unregister, deadlocks of the remaining agents survive
+  for (int i = 0; i < (int)paths.size(); i += 3) {
+    table_frg.unregisterPath(i);
+    table_cyc.unregisterPath(i);
+    ASSERT_EQ(table_frg.getPotentialDeadlock() == nullptr,
+              table_cyc.getPotentialDeadlock() == nullptr);
+  }
+}
+
+TEST(TableFragment, cycleDetectionAfterMerge)
+{
+  auto G = Grid("8x8.map");
+  auto table = TableFragment(&G);
+  table.setCycleDetection(true);
+
+  // 0 -> 1 -> 2 -> 5 -> 0 merges components, 3 -> 4 is outside of them
+  table.registerNewPath(0, {G.getNode(0), G.getNode(1), G.getNode(2),
+                            G.getNode(5)});
+  table.registerNewPath(1, {G.getNode(0), G.getNode(4)});
+  table.registerNewPath(2, {G.getNode(3), G.getNode(4)});
+  ASSERT_EQ(table.registerNewPath(3, {G.getNode(5), G.getNode(0)}), nullptr);
+
+  ASSERT_TRUE(table.existPotentialDeadlock(4, G.getNode(4), G.getNode(3)));
+}
+
+TEST(TableFragment, countFrom)
+{
+  // A* breaks ties by fragments from each node, and by moves from each node
+  // with cycle detection, which does not enumerate fragments
+  auto G = Grid("8x8.map");
+  auto table_frg = TableFragment(&G);
+  auto table_cyc = TableFragment(&G);
+  table_cyc.setCycleDetection(true);
+
+  Path p1 = {G.getNode(0), G.getNode(1), G.getNode(2)};
+  Path p2 = {G.getNode(2), G.getNode(3)};
+  for (auto table : {&table_frg, &table_cyc}) {
+    ASSERT_EQ(table->registerNewPath(0, p1), nullptr);
+    ASSERT_EQ(table->registerNewPath(1, p2), nullptr);
+  }
+
+  // fragments 1 -> 2, 1 -> 2 -> 3, and one move 1 -> 2
+  ASSERT_EQ(table_frg.countFrom(1), 2);
+  ASSERT_EQ(table_cyc.countFrom(1), 1);
+  // the same when fragments consist of single moves
+  ASSERT_EQ(table_frg.countFrom(0), 1);
+  ASSERT_EQ(table_cyc.countFrom(0), 1);
+  ASSERT_EQ(table_frg.countFrom(3), 0);
+  ASSERT_EQ(table_cyc.countFrom(3), 0);
+}
+
+TEST(TableFragment, sccPruning)
+{
+  auto G = Grid("random-32-32-10.map");
+  std::mt19937 MT(2);
+  std::vector<Path> paths;
+  while (paths.size() < 40) {
+    auto s = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    auto g = G.getNode(getRandomInt(0, G.getNodesSize() - 1, &MT));
+    if (s == nullptr || g == nullptr || s == g) continue;
+    paths.push_back(G.getPath(s, g));
+  }
+
+  // deadlocks are found with fewer fragments
+  auto table_all = TableFragment(&G, 4);
+  auto table_scc = TableFragment(&G, 4);
+  table_scc.setSccPruning(true);
+  ASSERT_TRUE(table_scc.isSccPruning());
+  for (int i = 0; i < (int)paths.size(); ++i) {
+    table_all.registerNewPath(i, paths[i], true);
+    table_scc.registerNewPath(i, paths[i], true);
+    ASSERT_EQ(table_all.t_cycle.empty(), table_scc.t_cycle.empty());
+    ASSERT_LE(table_scc.getFragmentsNum(), table_all.getFragmentsNum());
+  }
+
+  // queries of moves, including moves across components
+  const int id = paths.size();
+  for (auto& p : paths) {
+    for (int t = 1; t < (int)p.size(); ++t) {
+      ASSERT_EQ(table_all.existPotentialDeadlock(id, p[t], p[t - 1]),
+                table_scc.existPotentialDeadlock(id, p[t], p[t - 1]));
+    }
+  }
+
+  // unregister then register again
+  for (int i = 0; i < (int)paths.size(); i += 2) {
+    table_all.unregisterPath(i);
+    table_scc.unregisterPath(i);
+    ASSERT_EQ(table_all.t_cycle.empty(), table_scc.t_cycle.empty());
+  }
+  for (int i = 0; i < (int)paths.size(); i += 2) {
+    table_all.registerNewPath(i, paths[i], true);
+    table_scc.registerNewPath(i, paths[i], true);
+    ASSERT_EQ(table_all.t_cycle.empty(), table_scc.t_cycle.empty());
+  }
+}
+
+TEST(TableFragment, statistics)
+{
+  auto G = Grid("8x8.map");
+  auto table = TableFragment(&G);
+
+  Path p1 = {G.getNode(0), G.getNode(1), G.getNode(2)};
+  Path p2 = {G.getNode(3), G.getNode(2), G.getNode(1)};
+  table.registerNewPath(0, p1, true);
+  table.registerNewPath(1, p2, true);
+
+  auto& stats = table.getStats();
+  ASSERT_EQ(stats.created, table.getFragmentsNum());
+  ASSERT_EQ(stats.peak_fragments, table.getLiveFragmentsNum());
+  ASSERT_GE(stats.peak_bytes, table.getArenaBytes());
+  ASSERT_GE(stats.max_bucket_from, 1);
+  ASSERT_GE(stats.max_bucket_to, 1);
+  std::size_t sum = 0;
+  for (auto cnt : stats.length_hist) sum += cnt;
+  ASSERT_EQ(sum, stats.created);
+  ASSERT_FALSE(table.isOverLimit());
+
+  // merge
+  FragmentStats total;
+  total.merge(stats);
+  total.merge(stats);
+  ASSERT_EQ(total.created, 2 * stats.created);
+  ASSERT_EQ(total.peak_fragments, stats.peak_fragments);
+}
+
+TEST(TableFragment, limit)
+{
+  auto G = Grid("8x8.map");
+  auto table = TableFragment(&G);
+  table.setFragmentsLimit(2);
+
+  Path p1 = {G.getNode(0), G.getNode(1), G.getNode(2), G.getNode(3)};
+  Path p2 = {G.getNode(4), G.getNode(3), G.getNode(2), G.getNode(1)};
+  ASSERT_EQ(table.registerNewPath(0, p1), nullptr);
+  ASSERT_TRUE(table.isOverLimit());
+
+  // registration stops like time limit
+  ASSERT_EQ(table.registerNewPath(1, p2), nullptr);
+  ASSERT_EQ(table.getLiveFragmentsNum(), 2);
+  ASSERT_TRUE(table.getStats().over_limit);
+}
+
+TEST(TableFragment, duplicationIndex)
+{
+  auto G = Grid("random-32-32-10.map");
+  auto paths = getRandomPaths(G, 40, 3);
+
+  // hash index and linear scan find the same duplicates
+  for (auto max_fragment_size : {4, 6}) {
+    auto table_idx = TableFragment(&G, max_fragment_size);
+    auto table_lin = TableFragment(&G, max_fragment_size);
+    table_lin.setDuplicationIndex(false);
+    for (int i = 0; i < (int)paths.size(); ++i) {
+      table_idx.registerNewPath(i, paths[i], true);
+      table_lin.registerNewPath(i, paths[i], true);
+      ASSERT_EQ(getFragmentSet(table_idx), getFragmentSet(table_lin));
+    }
+    ASSERT_EQ(table_idx.getStats().duplicates,
+              table_lin.getStats().duplicates);
+
+    // queries of moves
+    const int id = paths.size();
+    for (auto& p : paths) {
+      for (int t = 1; t < (int)p.size(); ++t) {
+        ASSERT_EQ(table_idx.existPotentialDeadlock(id, p[t], p[t - 1]),
+                  table_lin.existPotentialDeadlock(id, p[t], p[t - 1]));
+      }
+    }
+  }
+}
+
+TEST(TableFragment, signatures)
+{
+  auto G = Grid("random-32-32-10.map");
+  // more than 64 agents, signatures of agents have false positives
+  auto paths = getRandomPaths(G, 80, 5);
+
+  // filters by signatures never change connections of fragments
+  for (auto max_fragment_size : {3, 5}) {
+    auto table_sig = TableFragment(&G, max_fragment_size);
+    auto table_exact = TableFragment(&G, max_fragment_size);
+    table_exact.setDuplicationIndex(false);
+    table_exact.setSignatures(false);
+    for (int i = 0; i < (int)paths.size(); ++i) {
+      table_sig.registerNewPath(i, paths[i], true);
+      table_exact.registerNewPath(i, paths[i], true);
+      ASSERT_EQ(getFragmentSet(table_sig), getFragmentSet(table_exact));
+    }
+
+    // queries of moves, agents with and without fragments
+    for (auto id : {0, 40, (int)paths.size()}) {
+      for (auto& p : paths) {
+        for (int t = 1; t < (int)p.size(); ++t) {
+          ASSERT_EQ(table_sig.existPotentialDeadlock(id, p[t], p[t - 1]),
+                    table_exact.existPotentialDeadlock(id, p[t], p[t - 1]));
+        }
+      }
+    }
+  }
+}
+
+TEST(TableFragment, topologyMemo)
+{
+  auto G = Grid("random-32-32-10.map");
+  auto paths = getRandomPaths(G, 40, 7);
+  auto paths_new = getRandomPaths(G, 20, 8);
+
+  // balls and cache give the same verdicts as breadth first search
+  for (auto max_fragment_size : {3, 4, 6}) {
+    auto table_memo = TableFragment(&G, max_fragment_size);
+    auto table_exact = TableFragment(&G, max_fragment_size);
+    table_exact.setTopologyMemo(false);
+    for (int i = 0; i < (int)paths.size(); ++i) {
+      table_memo.registerNewPath(i, paths[i], true);
+      table_exact.registerNewPath(i, paths[i], true);
+      ASSERT_EQ(getFragmentSet(table_memo), getFragmentSet(table_exact));
+    }
+    ASSERT_GT(table_memo.getStats().topology, 0);
+
+    // cached verdicts are used again with new fragments
+    for (int i = 0; i < (int)paths_new.size(); ++i) {
+      table_memo.unregisterPath(i);
+      table_exact.unregisterPath(i);
+      table_memo.registerNewPath(i, paths_new[i], true);
+      table_exact.registerNewPath(i, paths_new[i], true);
+      ASSERT_EQ(getFragmentSet(table_memo), getFragmentSet(table_exact));
+    }
+    ASSERT_EQ(table_memo.getStats().topology,
+              table_exact.getStats().topology);
+
+    // queries of moves
+    const int id = paths.size();
+    for (auto& p : paths) {
+      for (int t = 1; t < (int)p.size(); ++t) {
+        ASSERT_EQ(table_memo.existPotentialDeadlock(id, p[t], p[t - 1]),
+                  table_exact.existPotentialDeadlock(id, p[t], p[t - 1]));
+      }
+    }
+  }
 }
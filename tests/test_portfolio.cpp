@@ -0,0 +1,105 @@
+#include <dbs.hpp>
+#include <distance_table.hpp>
+#include <execution.hpp>
+#include <fragment.hpp>
+#include <portfolio.hpp>
+#include <pp.hpp>
+
+#include "gtest/gtest.h"
+
+// the plan has no potential deadlocks and its execution is a valid MAPF plan
+static void assertValidPlan(Problem* P, Solver* solver)
+{
+  TableFragment table(P->getG());
+  auto plan = solver->getSolution();
+  ASSERT_EQ((int)plan.size(), P->getNum());
+  for (int i = 0; i < P->getNum(); ++i) {
+    ASSERT_EQ(table.registerNewPath(i, plan[i], true), nullptr);
+  }
+
+  const std::string plan_file = "./portfolio_test_plan.txt";
+  solver->makeLog(plan_file);
+  auto exec = MAPF_DP_Execution(P, plan_file, 0, 0.5);
+  exec.run();
+  std::remove(plan_file.c_str());
+  ASSERT_TRUE(exec.getExecSucceed());
+  ASSERT_TRUE(validateMAPFPlan(exec.getExecResult(), P));
+}
+
+// distances of the solver are the same as a new table
+static void assertSameDistances(Problem* P, Solver* solver)
+{
+  DistanceTable D(P);
+  D.create();
+  Graph* G = P->getG();
+  for (int i = 0; i < P->getNum(); ++i) {
+    for (int v = 0; v < G->getNodesSize(); ++v) {
+      Node* node = G->getNode(v);
+      if (node == nullptr) continue;
+      ASSERT_EQ(solver->pathDist(i, node),
+                D.get(i, P->getCSR()->getIndex(node)));
+    }
+  }
+}
+
+TEST(Portfolio, solve)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver = std::make_unique<Portfolio>(&P);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+  auto plan = solver->getSolution();
+  ASSERT_EQ((int)plan.size(), P.getNum());
+  for (int i = 0; i < P.getNum(); ++i) {
+    ASSERT_EQ(plan[i].front(), P.getStart(i));
+    ASSERT_EQ(plan[i].back(), P.getGoal(i));
+  }
+  ASSERT_NO_FATAL_FAILURE(assertValidPlan(&P, solver.get()));
+  ASSERT_NO_FATAL_FAILURE(assertSameDistances(&P, solver.get()));
+}
+
+TEST(Portfolio, params)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver = std::make_unique<Portfolio>(&P);
+
+  // shared options, then options only for each member
+  char argv0[] = "PORTFOLIO";
+  char argv1[] = "-z";
+  char argv2[] = "--pp";
+  char argv3[] = "-e -j 2";
+  char argv4[] = "--dbs=-c";
+  char* argv_solver[] = {argv0, argv1, argv2, argv3, argv4};
+  solver->setParams(5, argv_solver);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+  ASSERT_NO_FATAL_FAILURE(assertValidPlan(&P, solver.get()));
+}
+
+TEST(Portfolio, cancelMember)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  auto table = std::make_shared<DistanceTable>(&P);
+  table->create();
+
+  // the same as a member cancelled by the winner
+  Deadline race;
+  race.reset(-1);
+  race.cancel();
+  auto loser = std::make_unique<PP>(&P);
+  loser->setDistanceTable(table);
+  loser->setParentDeadline(&race);
+  loser->solve();
+  ASSERT_FALSE(loser->succeed());
+  ASSERT_NO_FATAL_FAILURE(assertSameDistances(&P, loser.get()));
+
+  // another member still uses the table
+  auto winner = std::make_unique<DBS>(&P);
+  winner->setDistanceTable(table);
+  winner->solve();
+  ASSERT_TRUE(winner->succeed());
+  ASSERT_NO_FATAL_FAILURE(assertValidPlan(&P, winner.get()));
+  ASSERT_NO_FATAL_FAILURE(assertSameDistances(&P, winner.get()));
+}
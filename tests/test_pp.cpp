@@ -1,7 +1,20 @@
 #include <pp.hpp>
+#include <thread>
 
 #include "gtest/gtest.h"
 
+// same nodes at every timestep, compared by ids since problems differ
+static void assertSamePlan(const Plan& plan1, const Plan& plan2)
+{
+  ASSERT_EQ(plan1.size(), plan2.size());
+  for (int i = 0; i < (int)plan1.size(); ++i) {
+    ASSERT_EQ(plan1[i].size(), plan2[i].size());
+    for (int t = 0; t < (int)plan1[i].size(); ++t) {
+      ASSERT_EQ(plan1[i][t]->id, plan2[i][t]->id);
+    }
+  }
+}
+
 TEST(PP, solve)
 {
   Problem P = Problem("../tests/instances/example.txt");
@@ -10,3 +23,204 @@ TEST(PP, solve)
 
   ASSERT_TRUE(solver->succeed());
 }
+
+TEST(PP, prefixRestart)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+
+  char argv0[] = "PP";
+  char argv1[] = "-e";
+  char* argv_solver[] = {argv0, argv1};
+
+  auto solver = std::make_unique<PP>(&P);
+  solver->setParams(2, argv_solver);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+}
+
+TEST(PP, prefixRestartReuse)
+{
+  // four agents rotate on a 2x2 grid, every order fails at the last agent
+  Problem P = Problem("../tests/instances/m-tolerant2.txt");
+  const int j_failed = P.getNum() - 1;
+
+  char argv0[] = "PP";
+  char argv1[] = "-m";
+  char argv2[] = "6";
+  char argv3[] = "-e";
+  char* argv_solver[] = {argv0, argv1, argv2, argv3};
+
+  for (int argc : {3, 4}) {
+    auto solver = std::make_unique<PP>(&P);
+    solver->setParams(argc, argv_solver);
+    solver->solve();
+    ASSERT_FALSE(solver->succeed());
+    ASSERT_EQ(solver->getIterCnt(), 6);
+
+    // each restart registers agents from the kept position k to the failed
+    // one, the prefix is not registered again
+    const int reused = solver->getReusedPathsCnt();
+    ASSERT_EQ(solver->getRegisteredPathsCnt() + reused, 6 * j_failed);
+    if (argc == 3) {
+      ASSERT_EQ(reused, 0);
+    } else {
+      ASSERT_GT(reused, 0);
+    }
+  }
+}
+
+TEST(PP, threads)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+
+  char argv0[] = "PP";
+  char argv1[] = "-j";
+  char argv2[] = "3";
+  char* argv_solver[] = {argv0, argv1, argv2};
+
+  auto solver = std::make_unique<PP>(&P);
+  solver->setParams(3, argv_solver);
+  solver->solve();
+
+  ASSERT_TRUE(solver->succeed());
+  auto plan = solver->getSolution();
+  ASSERT_EQ(plan.size(), P.getNum());
+  for (int i = 0; i < P.getNum(); ++i) {
+    ASSERT_EQ(plan[i].front(), P.getStart(i));
+    ASSERT_EQ(plan[i].back(), P.getGoal(i));
+  }
+  ASSERT_GE(solver->getWinnerIterCnt(), 1);
+  ASSERT_LE(solver->getWinnerIterCnt(), solver->getIterCnt());
+  ASSERT_LE(solver->getIterCnt(), 10);  // default of -m
+}
+
+TEST(PP, threadsIterCntMax)
+{
+  // every order of priorities fails
+  Problem P = Problem("../tests/instances/m-tolerant.txt");
+
+  char argv0[] = "PP";
+  char argv1[] = "-j";
+  char argv2[] = "3";
+  char argv3[] = "-m";
+  char argv4[] = "7";
+  char* argv_solver[] = {argv0, argv1, argv2, argv3, argv4};
+
+  auto solver = std::make_unique<PP>(&P);
+  solver->setParams(5, argv_solver);
+  solver->solve();
+
+  // -m bounds restarts of all workers, not of each
+  ASSERT_FALSE(solver->succeed());
+  ASSERT_EQ(solver->getWinnerIterCnt(), -1);
+  ASSERT_LE(solver->getIterCnt(), 7);
+  ASSERT_GT(solver->getIterCnt(), 0);
+}
+
+TEST(PP, distanceThreads)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+
+  char argv0[] = "PP";
+  char argv1[] = "-t";
+  char argv2[] = "3";
+  char* argv_solver[] = {argv0, argv1, argv2};
+
+  auto solver1 = std::make_unique<PP>(&P);
+  solver1->solve();
+
+  // rows computed by threads are the same as sequential ones
+  Problem P2 = Problem("../tests/instances/example.txt");
+  auto solver2 = std::make_unique<PP>(&P2);
+  solver2->setParams(3, argv_solver);
+  solver2->solve();
+
+  ASSERT_TRUE(solver2->succeed());
+  ASSERT_NO_FATAL_FAILURE(
+      assertSamePlan(solver1->getSolution(), solver2->getSolution()));
+}
+
+TEST(PP, bitParallelBFS)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+
+  char argv0[] = "PP";
+  char argv1[] = "-w";
+  char* argv_solver[] = {argv0, argv1};
+
+  auto solver1 = std::make_unique<PP>(&P);
+  solver1->solve();
+
+  // 64 goals searched at once give the same distances as one BFS per goal
+  Problem P2 = Problem("../tests/instances/example.txt");
+  auto solver2 = std::make_unique<PP>(&P2);
+  solver2->setParams(2, argv_solver);
+  solver2->solve();
+
+  ASSERT_TRUE(solver2->succeed());
+  ASSERT_NO_FATAL_FAILURE(
+      assertSamePlan(solver1->getSolution(), solver2->getSolution()));
+}
+
+TEST(PP, nodeOrder)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver1 = std::make_unique<PP>(&P);
+  solver1->solve();
+  auto plan1 = solver1->getSolution();
+
+  // renumbering nodes changes memory layout only, node ids are kept
+  for (auto order : {CSRGraph::HILBERT, CSRGraph::RCM}) {
+    Problem P2 = Problem("../tests/instances/example.txt");
+    P2.setNodeOrder(order);
+    auto solver2 = std::make_unique<PP>(&P2);
+    solver2->solve();
+
+    ASSERT_TRUE(solver2->succeed());
+    ASSERT_NO_FATAL_FAILURE(assertSamePlan(plan1, solver2->getSolution()));
+  }
+}
+
+TEST(PP, concurrentSolvers)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver1 = std::make_unique<PP>(&P);
+  solver1->solve();
+  auto plan1 = solver1->getSolution();
+
+  // solvers share the problem, its graph and CSR, but not their RNGs,
+  // so each of them finds the same plan as a solver alone
+  std::vector<std::unique_ptr<PP>> solvers;
+  for (int k = 0; k < 4; ++k) solvers.push_back(std::make_unique<PP>(&P));
+  std::vector<std::thread> threads;
+  for (auto& solver : solvers) {
+    threads.emplace_back([&solver]() { solver->solve(); });
+  }
+  for (auto& th : threads) th.join();
+
+  for (auto& solver : solvers) {
+    ASSERT_TRUE(solver->succeed());
+    ASSERT_NO_FATAL_FAILURE(assertSamePlan(plan1, solver->getSolution()));
+  }
+}
+
+TEST(PP, sccPruning)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  auto solver1 = std::make_unique<PP>(&P);
+  solver1->solve();
+  auto plan1 = solver1->getSolution();
+
+  // -g is ignored since the tie-break of A* counts all fragments
+  char argv0[] = "PP";
+  char argv1[] = "-g";
+  char* argv_solver[] = {argv0, argv1};
+  Problem P2 = Problem("../tests/instances/example.txt");
+  auto solver2 = std::make_unique<PP>(&P2);
+  solver2->setParams(2, argv_solver);
+  solver2->solve();
+
+  ASSERT_TRUE(solver2->succeed());
+  ASSERT_NO_FATAL_FAILURE(assertSamePlan(plan1, solver2->getSolution()));
+}
@@ -20,3 +20,75 @@ TEST(Problem, loading)
   ASSERT_EQ(goals[0], G->getNode(1, 0));
   ASSERT_EQ(goals[1], G->getNode(0, 1));
 }
+
+TEST(Problem, csr)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  Graph* G = P.getG();
+  auto csr = P.getCSR();
+
+  ASSERT_EQ(csr->getNodesSize(), G->getNodesSize());
+  for (int v = 0; v < G->getNodesSize(); ++v) {
+    Node* n = G->getNode(v);
+    ASSERT_EQ(csr->getNode(v), n);
+    if (n == nullptr) {
+      ASSERT_EQ(csr->getNeighbors(v).size(), 0);
+      continue;
+    }
+    // same order as Node::neighbor
+    ASSERT_EQ(csr->getNeighbors(v).size(), (int)n->neighbor.size());
+    int k = 0;
+    for (auto u : csr->getNeighbors(v)) ASSERT_EQ(u, n->neighbor[k++]->id);
+  }
+
+  int goals_num = 0;
+  for (int v = 0; v < G->getNodesSize(); ++v) {
+    if (csr->isGoal(v)) ++goals_num;
+  }
+  ASSERT_EQ(goals_num, P.getNum());
+  for (int i = 0; i < P.getNum(); ++i) {
+    ASSERT_TRUE(csr->isGoal(P.getGoal(i)->id));
+  }
+}
+
+TEST(Problem, nodeOrder)
+{
+  for (auto order : {CSRGraph::HILBERT, CSRGraph::RCM}) {
+    Problem P = Problem("../tests/instances/example.txt");
+    P.setNodeOrder(order);
+    Graph* G = P.getG();
+    auto csr = P.getCSR();
+
+    // all nodes except obstacles, once for each
+    int nodes_num = 0;
+    for (int id = 0; id < G->getNodesSize(); ++id) {
+      Node* n = G->getNode(id);
+      if (n == nullptr) continue;
+      ++nodes_num;
+      const int v = csr->getIndex(n);
+      ASSERT_EQ(csr->getNode(v), n);
+      int k = 0;
+      for (auto u : csr->getNeighbors(v)) {
+        ASSERT_EQ(csr->getNode(u), n->neighbor[k++]);
+      }
+      ASSERT_EQ(csr->isGoal(n), csr->isGoal(v));
+    }
+    ASSERT_EQ(csr->getNodesSize(), nodes_num);
+    for (int i = 0; i < P.getNum(); ++i) {
+      ASSERT_TRUE(csr->isGoal(P.getGoal(i)));
+    }
+  }
+}
+
+TEST(Problem, RNG)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+
+  // solvers get copies, the same sequence for the same stream
+  auto rng1 = P.getRNG();
+  auto rng2 = P.getRNG();
+  ASSERT_EQ(rng1(), rng2());
+  ASSERT_EQ(P.getRNG(1), P.getRNG(1));
+  ASSERT_NE(P.getRNG(1), P.getRNG(2));
+  ASSERT_NE(P.getRNG(0), P.getRNG(1));
+}
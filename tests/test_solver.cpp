@@ -0,0 +1,215 @@
+#include <solver.hpp>
+
+#include "gtest/gtest.h"
+
+TEST(BucketQueue, order)
+{
+  // pairs of (key, value), the comparator sees only value / 4
+  using Item = std::pair<int, int>;
+  auto compare = [](const Item& a, const Item& b) {
+    return a.second / 4 > b.second / 4;
+  };
+
+  // reference: one heap ordered by (key, comparator, push order)
+  struct Entry {
+    Item x;
+    int stamp;
+  };
+  auto compare_ref = [&](const Entry& a, const Entry& b) {
+    if (a.x.first != b.x.first) return a.x.first > b.x.first;
+    if (compare(a.x, b.x)) return true;
+    if (compare(b.x, a.x)) return false;
+    return a.stamp > b.stamp;
+  };
+  std::priority_queue<Entry, std::vector<Entry>, decltype(compare_ref)> ref(
+      compare_ref);
+
+  std::mt19937 MT(0);
+  BucketQueue<Item> queue;
+  for (int round = 0; round < 2; ++round) {
+    int stamp = 0;
+    for (int k = 0; k < 2000; ++k) {
+      // pushes and pops are interleaved
+      if (getRandomInt(0, 2, &MT) > 0 || ref.empty()) {
+        Item x = {getRandomInt(0, 9, &MT), getRandomInt(0, 15, &MT)};
+        queue.push(x, x.first, compare);
+        ref.push({x, stamp++});
+      } else {
+        ASSERT_EQ(queue.pop(compare), ref.top().x);
+        ref.pop();
+      }
+    }
+    while (!ref.empty()) {
+      ASSERT_FALSE(queue.empty());
+      ASSERT_EQ(queue.pop(compare), ref.top().x);
+      ref.pop();
+    }
+    ASSERT_TRUE(queue.empty());
+    // reuse after clear
+    queue.clear();
+  }
+}
+
+// plain A* search as a reference of getPathWithPolicy
+class ReferenceSolver : public Solver
+{
+public:
+  ReferenceSolver(Problem* _P) : Solver(_P) {}
+
+  using Solver::getExpandedNum;
+  std::mt19937& getMT() { return rng; }
+
+  // nodes are allocated one by one, CLOSE is created for each search
+  template <typename CheckInvalid, typename Compare, typename GetKey>
+  Path getPathReference(const int id, CheckInvalid&& checkInvalidMove,
+                        Compare&& compare, GetKey&& getKey, int& expanded)
+  {
+    Node* const g = P->getGoal(id);
+    struct Entry {
+      AstarNode* a;
+      int key;
+      int stamp;
+    };
+    auto compare_entry = [&](const Entry& x, const Entry& y) {
+      if (x.key != y.key) return x.key > y.key;
+      if (compare(x.a, y.a)) return true;
+      if (compare(y.a, x.a)) return false;
+      return x.stamp > y.stamp;
+    };
+    std::priority_queue<Entry, std::vector<Entry>, decltype(compare_entry)>
+        OPEN(compare_entry);
+    std::vector<std::unique_ptr<AstarNode>> nodes;
+    std::vector<bool> CLOSE(csr->getNodesSize(), false);
+    int stamp = 0;
+    auto pushOpen = [&](Node* v, int g_cost, int f_cost, AstarNode* p) {
+      nodes.push_back(
+          std::make_unique<AstarNode>(AstarNode{v, g_cost, f_cost, p}));
+      OPEN.push({nodes.back().get(), getKey(nodes.back().get()), stamp++});
+    };
+
+    expanded = 0;
+    pushOpen(P->getStart(id), 0, pathDist(id, P->getStart(id)), nullptr);
+    AstarNode* n = nullptr;
+    bool found = false;
+    while (!OPEN.empty()) {
+      n = OPEN.top().a;
+      OPEN.pop();
+      const int v = csr->getIndex(n->v);
+      if (CLOSE[v]) continue;
+      CLOSE[v] = true;
+      ++expanded;
+      if (n->v == g) {
+        found = true;
+        break;
+      }
+      auto neighbors = csr->getNeighbors(v);
+      std::vector<int> C(neighbors.begin(), neighbors.end());
+      std::shuffle(C.begin(), C.end(), *MT);
+      for (auto u : C) {
+        if (CLOSE[u]) continue;
+        Node* const child = csr->getNode(u);
+        if (checkInvalidMove(child, n->v)) continue;
+        pushOpen(child, n->g + 1, n->g + 1 + pathDist(id, child), n);
+      }
+    }
+
+    Path path;
+    while (found && n != nullptr) {
+      path.push_back(n->v);
+      n = n->p;
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+  }
+};
+
+TEST(Solver, astar)
+{
+  Problem P = Problem("../tests/instances/example.txt");
+  ReferenceSolver solver(&P);
+  solver.createDistanceTable();
+  auto csr = P.getCSR();
+
+  auto compare_h = [](Solver::AstarNode* a, Solver::AstarNode* b) {
+    if (a->g != b->g) return a->g < b->g;
+    return false;
+  };
+  auto getKeyF = [](Solver::AstarNode* a) { return a->f; };
+  auto getKeyH = [](Solver::AstarNode* a) { return a->f - a->g; };
+  auto getKeyZero = [](Solver::AstarNode*) { return 0; };
+
+  // consecutive searches on the same workspace
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < P.getNum(); ++i) {
+      Node* const g = P.getGoal(i);
+      // avoid goals of others, and some moves depending on agents
+      auto checkInvalidMove = [&](Node* child, Node* parent) {
+        if (child != g && csr->isGoal(child)) return true;
+        return (child->id + parent->id + i) % 7 == 0;
+      };
+
+      for (int policy = 0; policy < 3; ++policy) {
+        const auto state = solver.getMT();
+        Path path;
+        if (policy == 0) {
+          path = solver.getPathWithPolicy(i, checkInvalidMove,
+                                          Solver::compareAstarNodesDefault,
+                                          getKeyF);
+        } else if (policy == 1) {
+          path =
+              solver.getPathWithPolicy(i, checkInvalidMove, compare_h, getKeyH);
+        } else {
+          path = solver.getPath(i, checkInvalidMove);
+        }
+        const int expanded = solver.getExpandedNum();
+
+        // the same random sequence
+        solver.getMT() = state;
+        int expanded_ref = 0;
+        Path path_ref;
+        if (policy == 0) {
+          path_ref = solver.getPathReference(i, checkInvalidMove,
+                                             Solver::compareAstarNodesDefault,
+                                             getKeyF, expanded_ref);
+        } else if (policy == 1) {
+          path_ref = solver.getPathReference(i, checkInvalidMove, compare_h,
+                                             getKeyH, expanded_ref);
+        } else {
+          path_ref = solver.getPathReference(i, checkInvalidMove,
+                                             Solver::compareAstarNodesDefault,
+                                             getKeyZero, expanded_ref);
+        }
+
+        ASSERT_EQ(expanded, expanded_ref);
+        ASSERT_EQ(path, path_ref);
+        ASSERT_GT(expanded, 0);
+      }
+    }
+  }
+}
+
+TEST(Deadline, remainedTime)
+{
+  Deadline unlimited;
+  ASSERT_EQ(unlimited.getRemainedTime(), -1);
+
+  // the minimum with the parent
+  Deadline parent(100);
+  Deadline child(100000);
+  child.setParent(&parent);
+  ASSERT_LE(child.getRemainedTime(), 100);
+  unlimited.setParent(&parent);
+  ASSERT_LE(unlimited.getRemainedTime(), 100);
+  ASSERT_GE(unlimited.getRemainedTime(), 0);
+
+  // the parent without time limit
+  Deadline parent_unlimited;
+  Deadline child_limited(100);
+  child_limited.setParent(&parent_unlimited);
+  ASSERT_LE(child_limited.getRemainedTime(), 100);
+  ASSERT_GE(child_limited.getRemainedTime(), 0);
+
+  parent.cancel();
+  ASSERT_TRUE(child.expiredNow());
+  ASSERT_EQ(child.getRemainedTime(), 0);
+}